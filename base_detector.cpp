@@ -1,17 +1,19 @@
 #include "platform.hpp"
 #include "base_detector.hpp"
+#include "utils.h"
 
 using namespace InferenceEngine;
 
 BaseDetector::BaseDetector(std::string topoName,
 	const std::string &pathToModel,
 	const std::string &deviceForInference,
-	int maxBatch, bool isBatchDynamic, bool isAsync)
+	int maxBatch, bool isBatchDynamic, bool isAsync, int numRequests)
 	: topoName(topoName), pathToModel(pathToModel), deviceForInference(deviceForInference),
 	maxBatch(maxBatch), isBatchDynamic(isBatchDynamic), isAsync(isAsync),
-	enablingChecked(false), _enabled(false) {
+	numRequests(isAsync ? std::max(numRequests, 1) : 1), pluginPreprocessing(false),
+	enablingChecked(false), _enabled(false), _current(-1) {
 	if (isAsync) {
-		slog::info << "Use async mode for " << topoName << slog::endl;
+		slog::info << "Use async mode for " << topoName << " with " << this->numRequests << " infer requests" << slog::endl;
 	}
 }
 
@@ -21,26 +23,96 @@ ExecutableNetwork* BaseDetector::operator ->() {
 	return &net;
 }
 
+void BaseDetector::createRequests() {
+	if (!enabled()) return;
+	std::lock_guard<std::mutex> lock(_mutex);
+	requests.clear();
+	_idle.clear();
+	_completed.clear();
+	_current = -1;
+	for (int i = 0; i < numRequests; i++) {
+		Request request;
+		request.request = net.CreateInferRequestPtr();
+		if (isAsync) {
+			request.request->SetCompletionCallback(std::function<void()>([this, i] { onCompleted(i); }));
+		}
+		requests.push_back(request);
+		_idle.push_back(i);
+	}
+}
+
+int BaseDetector::currentRequest() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_current < 0) {
+		if (_idle.empty()) {
+			throw std::logic_error(topoName + " has no idle infer request to fill");
+		}
+		_current = _idle.front();
+		_idle.pop_front();
+	}
+	return _current;
+}
+
 void BaseDetector::submitRequest() {
-	if (!enabled() || request == nullptr) return;
+	if (!enabled()) return;
+	int index;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_current < 0) return;
+		index = _current;
+		_current = -1;
+	}
 	if (isAsync) {
-		request->StartAsync();
+		requests[index].request->StartAsync();
 	}
 	else {
-		request->Infer();
+		requests[index].request->Infer();
+		onCompleted(index);
 	}
 }
 
-void BaseDetector::wait() {
-	if (!enabled() || !request || !isAsync)
-		return;
-	request->Wait(IInferRequest::WaitMode::RESULT_READY);
+int BaseDetector::waitCompleted(std::chrono::milliseconds timeout) {
+	int index;
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		if (!_completion.wait_for(lock, timeout, [this] { return !_completed.empty(); })) {
+			return -1;
+		}
+		index = _completed.front();
+		_completed.pop_front();
+	}
+	if (isAsync) {
+		// The callback only reports completion, the status tells whether the outputs are valid
+		StatusCode status = requests[index].request->Wait(IInferRequest::WaitMode::RESULT_READY);
+		if (status != StatusCode::OK) {
+			releaseRequest(index);
+			throw std::logic_error(topoName + " infer request failed with status " + std::to_string(status));
+		}
+	}
+	return index;
 }
 
-StatusCode BaseDetector::status() {
-	if (!enabled() || !request || !isAsync)
-		return StatusCode::GENERAL_ERROR;
-	return request->Wait(IInferRequest::WaitMode::STATUS_ONLY);
+void BaseDetector::releaseRequest(int index) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_idle.push_back(index);
+}
+
+size_t BaseDetector::idleRequests() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _idle.size();
+}
+
+size_t BaseDetector::busyRequests() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return requests.size() - _idle.size() - (_current >= 0 ? 1 : 0);
+}
+
+void BaseDetector::onCompleted(int index) {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_completed.push_back(index);
+	}
+	_completion.notify_one();
 }
 
 bool BaseDetector::enabled() const {
@@ -55,14 +127,29 @@ bool BaseDetector::enabled() const {
 }
 
 void BaseDetector::printPerformanceCounts() {
-	if (!enabled()) {
+	if (!enabled() || requests.empty()) {
 		return;
 	}
 	slog::info << "Performance counts for " << topoName << slog::endl << slog::endl;
-	::printPerformanceCounts(request->GetPerformanceCounts(), std::cout, false);
+	::printPerformanceCounts(requests.front().request->GetPerformanceCounts(), std::cout, false);
 }
 
-LoadDetector::LoadDetector(BaseDetector& detector) : detector(detector) {
+LoadDetector::LoadDetector(BaseDetector& detector, const NetworkCache *cache) : detector(detector), cache(cache) {
+}
+
+/** Whether the network takes its inputs with the precisions and layouts read() set up **/
+static bool sameInputs(CNNNetwork &network, const ExecutableNetwork &net) {
+	InputsDataMap expected(network.getInputsInfo());
+	ConstInputsDataMap actual(net.GetInputsInfo());
+	if (actual.size() != expected.size()) return false;
+	for (auto &input : expected) {
+		auto found = actual.find(input.first);
+		if (found == actual.end() || found->second->getPrecision() != input.second->getPrecision() ||
+			found->second->getLayout() != input.second->getLayout()) {
+			return false;
+		}
+	}
+	return true;
 }
 
 void LoadDetector::into(InferencePlugin & plg, bool enable_dynamic_batch) const {
@@ -71,7 +158,36 @@ void LoadDetector::into(InferencePlugin & plg, bool enable_dynamic_batch) const
 		if (enable_dynamic_batch) {
 			config[PluginConfigParams::KEY_DYN_BATCH_ENABLED] = PluginConfigParams::YES;
 		}
-		detector.net = plg.LoadNetwork(detector.read(), config);
+		// One CPU stream per request lets the pooled requests run in parallel
+		if (detector.numRequests > 1 && detector.deviceForInference.find("CPU") != std::string::npos) {
+			config[PluginConfigParams::KEY_CPU_THROUGHPUT_STREAMS] = std::to_string(detector.numRequests);
+		}
+		Stopwatch load;
+		// The IR is read even when the compiled network is cached, the detector takes its inputs and outputs from it
+		CNNNetwork network = detector.read();
+		const bool cached = cache && cache->enabled() && cache->exports(detector.deviceForInference);
+		const std::string key = cached ? cache->key(detector.pathToModel, detector.deviceForInference, detector.maxBatch, config) : "";
+		const bool found = cached && cache->load(key, plg, config, detector.net);
+		// Some plugins import networks with their default input precisions and layouts
+		const bool imported = found && sameInputs(network, detector.net);
+		if (found && !imported) {
+			slog::warn << "Cached " << detector.topoName << " network takes other inputs, compiling it" << slog::endl;
+		}
+		if (!imported) {
+			detector.net = plg.LoadNetwork(network, config);
+			if (cached && !found) {
+				cache->store(key, detector.deviceForInference, detector.net);
+			}
+		}
+		// Imported networks keep no resize algorithm, the detectors resize their inputs themselves
+		detector.pluginPreprocessing = !imported;
 		detector.plugin = &plg;
+
+		// The first inference allocates and initializes the plugin's buffers, a throwaway request
+		// pays for it here instead of the first frame
+		detector.net.CreateInferRequest().Infer();
+		detector.createRequests();
+		slog::info << detector.topoName << " loaded in " << load.elapsedMs() << " ms"
+			<< (imported ? " from the network cache" : "") << slog::endl;
 	}
 }
\ No newline at end of file
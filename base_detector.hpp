@@ -4,40 +4,78 @@
 #include <inference_engine.hpp>
 #include <samples/slog.hpp>
 #include <samples/ocv_common.hpp>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include "network_cache.hpp"
 
 struct BaseDetector {
+	/** Pooled infer request with the sequence numbers of the frames in its batch **/
+	struct Request {
+		InferenceEngine::InferRequest::Ptr request;
+		std::vector<size_t> frameIds;
+	};
+
 	InferenceEngine::ExecutableNetwork net;
 	InferenceEngine::InferencePlugin * plugin;
-	InferenceEngine::InferRequest::Ptr request;
+	std::vector<Request> requests;
 	std::string topoName;
 	std::string pathToModel;
 	std::string deviceForInference;
 	const int maxBatch;
 	bool isBatchDynamic;
 	const bool isAsync;
+	const int numRequests;
+	/** Whether the plugin runs the input preprocessing set up by read(), networks imported from the cache lose it **/
+	bool pluginPreprocessing;
 	mutable bool enablingChecked;
 	mutable bool _enabled;
 
 	BaseDetector(std::string topoName,
 		const std::string &pathToModel,
 		const std::string &deviceForInference,
-		int maxBatch, bool isBatchDynamic, bool isAsync);
+		int maxBatch, bool isBatchDynamic, bool isAsync, int numRequests = 1);
 
 	virtual ~BaseDetector();
 
 	InferenceEngine::ExecutableNetwork* operator ->();
 	virtual InferenceEngine::CNNNetwork read() = 0;
+	/** Creates the request pool once the network is loaded **/
+	virtual void createRequests();
+	/** Starts the request filled by the last enqueue calls **/
 	virtual void submitRequest();
-	virtual void wait();
-	virtual InferenceEngine::StatusCode status();
+	/** Waits up to timeout for a completed request, returns its index or -1 **/
+	int waitCompleted(std::chrono::milliseconds timeout);
+	/** Returns a completed request to the pool after its outputs were read **/
+	void releaseRequest(int index);
+	size_t idleRequests();
+	size_t busyRequests();
 	bool enabled() const;
 	void printPerformanceCounts();
+
+protected:
+	/** Request being filled by enqueue, taken from the idle ones on first use **/
+	int currentRequest();
+
+private:
+	std::mutex _mutex;
+	std::condition_variable _completion;
+	std::deque<int> _idle;
+	std::deque<int> _completed;
+	int _current;
+
+	void onCompleted(int index);
 };
 
 struct LoadDetector {
 	BaseDetector& detector;
+	const NetworkCache *cache;
 
-	explicit LoadDetector(BaseDetector& detector);
+	explicit LoadDetector(BaseDetector& detector, const NetworkCache *cache = nullptr);
 
+	/**
+	* Loads the network with one CPU throughput stream per pooled request, imported from the cache
+	* when it has the compiled network, runs a warm-up inference and creates the pool
+	**/
 	void into(InferenceEngine::InferencePlugin & plg, bool enable_dynamic_batch = false) const;
 };
@@ -0,0 +1,222 @@
+#include "platform.hpp"
+#include <gflags/gflags.h>
+#include <inference_engine.hpp>
+#include <samples/ocv_common.hpp>
+#include <samples/slog.hpp>
+
+#include "utils.h"
+#include "benchmark.hpp"
+#include "pipeline.hpp"
+#include "result_sink.hpp"
+#include "trace.hpp"
+
+using namespace InferenceEngine;
+
+static std::string jsonString(const std::string &value) {
+	std::ostringstream out;
+	out << '"';
+	for (char c : value) {
+		if (c == '"' || c == '\\') {
+			out << '\\' << c;
+		} else if (static_cast<unsigned char>(c) < 0x20) {
+			out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+		} else {
+			out << c;
+		}
+	}
+	out << '"';
+	return out.str();
+}
+
+bool ParseAndCheckCommandLine(int argc, char *argv[]) {
+    gflags::ParseCommandLineNonHelpFlags(&argc, &argv, true);
+    if (FLAGS_h) {
+        showBenchmarkUsage();
+        return false;
+    }
+    slog::info << "Parsing input parameters" << slog::endl;
+
+    checkFlags();
+
+    if (FLAGS_niter < 1) {
+        throw std::logic_error("Parameter -niter should be at least 1");
+    }
+
+    return true;
+}
+
+
+int main(int argc, char *argv[]) {
+    try {
+        // Cold start runs from here to the first tracked frame
+        Stopwatch startup;
+        std::cout << "InferenceEngine: " << GetInferenceEngineVersion() << std::endl;
+
+        if (!ParseAndCheckCommandLine(argc, argv)) {
+            return 0;
+        }
+
+        const std::vector<std::string> sources = sourcesFromFlags();
+
+        // --------------------------- Loading the plugins and the networks --------------------------------
+        Networks networks;
+        networks.load();
+        const double networksMs = startup.elapsedMs();
+        slog::info << "Networks ready " << networksMs << " ms after start" << slog::endl;
+        // ----------------------------------------------------------------------------------------------------
+
+        const PipelineConfig config = pipelineConfigFromFlags();
+
+        // --------------------------- Running the iterations -------------------------------------------------
+        if (!FLAGS_trace.empty()) {
+            Trace::enable(FLAGS_trace_events);
+            Trace::nameThread("main");
+        }
+
+        // Publishing results is part of the measured loop when an output is set
+        std::unique_ptr<ResultSink> resultSink;
+        if (!FLAGS_out.empty()) {
+            resultSink = openResultSink(FLAGS_out);
+        }
+
+        // Stage histograms accumulate over all iterations
+        std::vector<std::pair<size_t, double>> iterations;
+        size_t totalFrames = 0;
+        size_t totalDropped = 0;
+        double firstFrameMs = 0.0;
+        size_t totalDetections = 0;
+        size_t totalEscalations = 0;
+        double totalMs = 0.0;
+
+        for (size_t iteration = 0; iteration < FLAGS_niter; iteration++) {
+            Stopwatch timer;
+
+            // Every iteration reopens the sources and starts from empty tracking state
+            Pipeline pipeline(sources, networks.faceDetector, networks.escalationDetector, networks.headPoseDetector,
+                              networks.landmarksDetector, config);
+            pipeline.start();
+
+            size_t framesCounter = 0;
+            TrackedFrame tracked;
+            while (pipeline.pop(tracked)) {
+                framesCounter++;
+                if (!iteration && framesCounter == 1) {
+                    firstFrameMs = startup.elapsedMs();
+                }
+                if (resultSink) {
+                    ScopedStage output(Stage::Output);
+                    resultSink->write(tracked);
+                }
+            }
+            pipeline.join();
+            totalDropped += pipeline.droppedFrames();
+            totalDetections += pipeline.detections();
+            totalEscalations += pipeline.escalations();
+
+            const double ms = timer.elapsedMs();
+            iterations.emplace_back(framesCounter, ms);
+            totalFrames += framesCounter;
+            totalMs += ms;
+            slog::info << "Iteration " << iteration << ": " << framesCounter << " frames, "
+                       << framesCounter * (1000.0 / ms) << " fps" << slog::endl;
+        }
+        // ----------------------------------------------------------------------------------------------------
+
+        // --------------------------- Writing the report -----------------------------------------------------
+        std::ofstream report(FLAGS_report);
+        if (!report) {
+            throw std::logic_error("Cannot open report file: " + FLAGS_report);
+        }
+        report << std::fixed << std::setprecision(3);
+        report << "{\n";
+        report << "  \"config\": {\n";
+        report << "    \"inputs\": [";
+        for (size_t i = 0; i < sources.size(); i++) {
+            report << (i ? ", " : "") << jsonString(sources[i]);
+        }
+        report << "],\n";
+        report << "    \"model\": " << jsonString(FLAGS_m) << ",\n";
+        report << "    \"escalation_model\": " << jsonString(FLAGS_m_esc) << ",\n";
+        report << "    \"esc_conf\": " << FLAGS_esc_conf << ",\n";
+        report << "    \"device\": " << jsonString(FLAGS_d) << ",\n";
+        report << "    \"async\": " << (FLAGS_async ? "true" : "false") << ",\n";
+        report << "    \"nireq\": " << FLAGS_nireq << ",\n";
+        report << "    \"batch\": " << FLAGS_b << ",\n";
+        report << "    \"head_pose\": " << (networks.headPoseDetector.enabled() ? "true" : "false") << ",\n";
+        report << "    \"landmarks\": " << (networks.landmarksDetector.enabled() ? "true" : "false") << ",\n";
+        report << "    \"det_min\": " << FLAGS_det_min << ",\n";
+        report << "    \"det_max\": " << FLAGS_det_max << ",\n";
+        report << "    \"drift\": " << FLAGS_drift << ",\n";
+        report << "    \"roi_scale\": " << FLAGS_roi_scale << ",\n";
+        report << "    \"roi_max\": " << FLAGS_roi_max << ",\n";
+        report << "    \"full_scan\": " << FLAGS_full_scan << ",\n";
+        report << "    \"tiles\": \"" << FLAGS_tile_cols << "x" << FLAGS_tile_rows << "\",\n";
+        report << "    \"tile_overlap\": " << FLAGS_tile_overlap << ",\n";
+        report << "    \"motion\": " << FLAGS_motion << ",\n";
+        report << "    \"refill\": " << FLAGS_refill << ",\n";
+        report << "    \"cache_dir\": " << jsonString(FLAGS_cache_dir) << ",\n";
+        report << "    \"out\": " << jsonString(FLAGS_out) << ",\n";
+        report << "    \"nthreads\": " << FLAGS_nthreads << ",\n";
+        report << "    \"niter\": " << FLAGS_niter << "\n";
+        report << "  },\n";
+        report << "  \"iterations\": [\n";
+        for (size_t i = 0; i < iterations.size(); i++) {
+            report << "    {\"frames\": " << iterations[i].first << ", \"ms\": " << iterations[i].second
+                   << ", \"fps\": " << iterations[i].first * (1000.0 / iterations[i].second) << "}"
+                   << (i + 1 < iterations.size() ? "," : "") << "\n";
+        }
+        report << "  ],\n";
+        report << "  \"startup_ms\": {\"networks\": " << networksMs << ", \"first_frame\": " << firstFrameMs << "},\n";
+        report << "  \"frames\": " << totalFrames << ",\n";
+        report << "  \"dropped\": " << totalDropped << ",\n";
+        report << "  \"detections\": " << totalDetections << ",\n";
+        report << "  \"escalations\": " << totalEscalations << ",\n";
+        report << "  \"fps\": " << totalFrames * (1000.0 / totalMs) << ",\n";
+        // The output stage runs after pop(), where end-to-end latencies stop
+        report << "  \"end_to_end\": \"capture to pop, output excluded\",\n";
+        report << "  \"stages_ms\": {\n";
+        bool firstStage = true;
+        for (int i = 0; i < static_cast<int>(Stage::Count); i++) {
+            const std::string name = stageName(static_cast<Stage>(i));
+            StageSnapshot summary = Instrumentation::snapshot(static_cast<Stage>(i));
+            if (!summary.count) continue;
+            report << (firstStage ? "" : ",\n");
+            report << "    " << jsonString(name) << ": {\"count\": " << summary.count
+                   << ", \"mean\": " << summary.mean << ", \"p50\": " << summary.p50
+                   << ", \"p95\": " << summary.p95 << ", \"p99\": " << summary.p99
+                   << ", \"max\": " << summary.max << "}";
+            firstStage = false;
+
+            slog::info << name << ": p50 " << summary.p50 << " ms, p95 " << summary.p95
+                       << " ms, p99 " << summary.p99 << " ms, max " << summary.max << " ms" << slog::endl;
+        }
+        report << "\n";
+        report << "  }\n";
+        report << "}\n";
+        // ----------------------------------------------------------------------------------------------------
+
+        slog::info << "Number of processed frames: " << totalFrames << slog::endl;
+        slog::info << "Total image throughput: " << totalFrames * (1000.0 / totalMs) << " fps" << slog::endl;
+        slog::info << "Report written to " << FLAGS_report << slog::endl;
+
+        if (Trace::enabled()) {
+            Trace::dump(FLAGS_trace);
+            slog::info << "Trace written to " << FLAGS_trace << slog::endl;
+        }
+
+        if (FLAGS_pc) {
+            networks.printPerformanceCounts();
+        }
+    }
+    catch (const std::exception& error) {
+        slog::err << error.what() << slog::endl;
+        return 1;
+    }
+    catch (...) {
+        slog::err << "Unknown/internal exception happened." << slog::endl;
+        return 1;
+    }
+
+    slog::info << "Execution successful" << slog::endl;
+    return 0;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "platform.hpp"
+#include <gflags/gflags.h>
+#include "cam_stream.hpp"
+
+/// @brief Message for the number of benchmark iterations
+static const char niter_message[] = "Optional. Number of times the input is run through the pipeline (default is 3).";
+
+/// @brief Message for the benchmark report path
+static const char report_message[] = "Optional. Path to the JSON file the benchmark report is written to (default is benchmark.json).";
+
+/// \brief Define parameter for the number of benchmark iterations<br>
+/// It is an optional parameter
+DEFINE_uint32(niter, 3, niter_message);
+
+/// \brief Define parameter for the benchmark report path<br>
+/// It is an optional parameter
+DEFINE_string(report, "benchmark.json", report_message);
+
+/**
+* \brief This function shows a help message for the benchmark options
+*/
+
+static void showBenchmarkUsage() {
+    showUsage();
+    std::cout << std::endl;
+    std::cout << "Benchmark options:" << std::endl;
+    std::cout << "    -niter \"<num>\"             " << niter_message << std::endl;
+    std::cout << "    -report \"<path>\"           " << report_message << std::endl;
+}
@@ -0,0 +1,300 @@
+#include "platform.hpp"
+#include <inference_engine.hpp>
+#include <samples/slog.hpp>
+
+#include <ie_iextension.h>
+#include <ext_list.hpp>
+
+#include "cam_stream.hpp"
+
+using namespace InferenceEngine;
+
+/// \brief Define flag for showing help message<br>
+DEFINE_bool(h, false, help_message);
+
+/// \brief Define parameter for set image file<br>
+/// It is a required parameter
+DEFINE_string(i, "cam", video_message);
+
+/// \brief Define parameter for Face Detection model file<br>
+/// It is a required parameter
+DEFINE_string(m, "", face_detection_model_message);
+
+/// \brief Define parameter for Face Detection  model file<br>
+/// It is a required parameter
+DEFINE_string(m_hp, "", head_pose_model_message);
+
+/// \brief Define parameter for Facial Landmarks Estimation model file<br>
+/// It is an optional parameter
+DEFINE_string(m_lm, "", facial_landmarks_model_message);
+
+/// \brief Define parameter for the escalation face detection model file<br>
+/// It is an optional parameter
+DEFINE_string(m_esc, "", escalation_model_message);
+
+/// \brief target device for Face Detection network<br>
+DEFINE_string(d, "CPU", target_device_message);
+
+/// \brief Define parameter for target device for Head Pose Estimation network<br>
+DEFINE_string(d_hp, "CPU", target_device_message_hp);
+
+/// \brief Define parameter for target device for Facial Landmarks Estimation network<br>
+DEFINE_string(d_lm, "CPU", target_device_message_lm);
+
+/// \brief Define parameter for maximum batch size for Head Pose Estimation network<br>
+DEFINE_uint32(n_hp, 16, num_batch_hp_message);
+
+/// \brief Define parameter to enable dynamic batch size for Head Pose Estimation network<br>
+DEFINE_bool(dyn_hp, false, dyn_batch_hp_message);
+
+/// \brief Define parameter for maximum batch size for Facial Landmarks Estimation network<br>
+DEFINE_uint32(n_lm, 16, num_batch_lm_message);
+
+/// \brief Define parameter to enable dynamic batch size for Facial Landmarks Estimation network<br>
+DEFINE_bool(dyn_lm, false, dyn_batch_lm_message);
+
+/// \brief Define parameter to enable per-layer performance report<br>
+DEFINE_bool(pc, false, performance_counter_message);
+
+/// @brief Define parameter for GPU custom kernels path<br>
+/// Default is ./lib
+DEFINE_string(c, "", custom_cldnn_message);
+
+/// @brief Define parameter for absolute path to CPU library with user layers<br>
+/// It is an optional parameter
+DEFINE_string(l, "", custom_cpu_library_message);
+
+/// \brief Define a flag to output raw scoring results<br>
+/// It is an optional parameter
+DEFINE_bool(r, false, raw_output_message);
+
+/// \brief Define a parameter for probability threshold for detections<br>
+/// It is an optional parameter
+DEFINE_double(t, 0.5, thresh_output_message);
+
+/// \brief Define a flag to disable keypress exit<br>
+/// It is an optional parameter
+DEFINE_bool(no_wait, false, no_wait_for_keypress_message);
+
+/// \brief Define a flag to disable showing processed video<br>
+/// It is an optional parameter
+DEFINE_bool(no_show, false, no_show_processed_video);
+
+/// \brief Define a flag to enable aynchronous execution<br>
+/// It is an optional parameter
+DEFINE_bool(async, false, async_message);
+
+/// \brief Define parameter for the number of infer requests<br>
+/// It is an optional parameter
+DEFINE_uint32(nireq, 1, nireq_message);
+
+/// \brief Define parameter for the minimum number of frames between detections<br>
+/// It is an optional parameter
+DEFINE_uint32(det_min, 5, det_min_message);
+
+/// \brief Define parameter for the maximum number of frames between detections<br>
+/// It is an optional parameter
+DEFINE_uint32(det_max, 60, det_max_message);
+
+/// \brief Define parameter for the tolerated drift of tracked faces<br>
+/// It is an optional parameter
+DEFINE_double(drift, 0.15, drift_message);
+
+/// \brief Define parameter for the number of frames kept for the detection replay<br>
+/// It is an optional parameter
+DEFINE_uint32(catchup_frames, 64, catchup_frames_message);
+
+/// \brief Define parameter for the memory limit of frames kept for the detection replay<br>
+/// It is an optional parameter
+DEFINE_uint32(catchup_mb, 64, catchup_mb_message);
+
+/// \brief Define parameter for the time budget per frame of the detection replay<br>
+/// It is an optional parameter
+DEFINE_double(catchup_ms, 2.0, catchup_ms_message);
+
+/// \brief Define parameter for maximum batch size for Face Detection network<br>
+/// It is an optional parameter
+DEFINE_uint32(b, 1, num_batch_message);
+
+/// \brief Define parameter for the longest wait of a partially filled Face Detection batch<br>
+/// It is an optional parameter
+DEFINE_double(batch_wait, 5.0, batch_wait_message);
+
+/// \brief Define parameter for the number of tracking threads<br>
+/// It is an optional parameter
+DEFINE_uint32(nthreads, 0, nthreads_message);
+
+/// \brief Define parameter for the capacity of the queues between pipeline stages<br>
+/// It is an optional parameter
+DEFINE_uint32(queue, 4, queue_message);
+
+/// \brief Define parameter for the size of the re-detected regions around tracks<br>
+/// It is an optional parameter
+DEFINE_double(roi_scale, 0.0, roi_scale_message);
+
+/// \brief Define parameter for the number of regions of one re-detection<br>
+/// It is an optional parameter
+DEFINE_uint32(roi_max, 2, roi_max_message);
+
+/// \brief Define parameter for the interval of full frame scans<br>
+/// It is an optional parameter
+DEFINE_uint32(full_scan, 4, full_scan_message);
+
+/// \brief Define parameters for the tile grid of full scans<br>
+/// It is an optional parameter
+DEFINE_uint32(tile_cols, 1, tile_cols_message);
+DEFINE_uint32(tile_rows, 1, tile_rows_message);
+
+/// \brief Define parameter for the overlap of neighbouring tiles<br>
+/// It is an optional parameter
+DEFINE_double(tile_overlap, 0.15, tile_overlap_message);
+
+/// \brief Define parameter for the motion gate threshold<br>
+/// It is an optional parameter
+DEFINE_double(motion, 0.0, motion_message);
+
+/// \brief Define parameter for the escalation confidence<br>
+/// It is an optional parameter
+DEFINE_double(esc_conf, 0.7, esc_conf_message);
+
+/// \brief Define parameter for the keypoint refill<br>
+/// It is an optional parameter
+DEFINE_double(refill, 0.5, refill_message);
+
+/// \brief Define parameter for the display rate<br>
+/// It is an optional parameter
+DEFINE_double(show_fps, 30.0, show_fps_message);
+
+/// \brief Define parameter for the compiled network cache<br>
+/// It is an optional parameter
+DEFINE_string(cache_dir, "", cache_dir_message);
+
+/// \brief Define parameter for the result output<br>
+/// It is an optional parameter
+DEFINE_string(out, "", out_message);
+
+/// \brief Define parameter for the trace output path<br>
+/// It is an optional parameter
+DEFINE_string(trace, "", trace_message);
+
+/// \brief Define parameter for the trace ring capacity<br>
+/// It is an optional parameter
+DEFINE_uint32(trace_events, 262144, trace_events_message);
+
+
+void checkFlags() {
+	if (FLAGS_i.find_first_not_of(',') == std::string::npos) {
+		throw std::logic_error("Parameter -i is not set");
+	}
+
+	if (FLAGS_m.empty()) {
+		throw std::logic_error("Parameter -m is not set");
+	}
+
+	if (FLAGS_b < 1) {
+		throw std::logic_error("Parameter -b should be at least 1");
+	}
+
+	if (FLAGS_tile_cols < 1 || FLAGS_tile_rows < 1 || FLAGS_tile_overlap < 0 || FLAGS_tile_overlap >= 1) {
+		throw std::logic_error("Parameters -tile_cols and -tile_rows should be at least 1, -tile_overlap in [0, 1)");
+	}
+
+	if (FLAGS_n_hp < 1 || FLAGS_n_lm < 1) {
+		throw std::logic_error("Parameters -n_hp and -n_lm should be at least 1");
+	}
+}
+
+std::vector<std::string> sourcesFromFlags() {
+	std::vector<std::string> sources;
+	std::istringstream sourceList(FLAGS_i);
+	for (std::string source; std::getline(sourceList, source, ',');) {
+		if (!source.empty()) {
+			sources.push_back(source);
+		}
+	}
+	return sources;
+}
+
+PipelineConfig pipelineConfigFromFlags() {
+	PipelineConfig config;
+	config.minDetectionInterval = FLAGS_det_min;
+	config.maxDetectionInterval = FLAGS_det_max;
+	config.driftTolerance = FLAGS_drift;
+	config.catchupFrames = FLAGS_catchup_frames;
+	config.catchupBytes = static_cast<size_t>(FLAGS_catchup_mb) << 20;
+	config.catchupMs = FLAGS_catchup_ms;
+	config.queueCapacity = FLAGS_queue;
+	config.workers = FLAGS_nthreads;
+	config.batchWaitMs = FLAGS_batch_wait;
+	config.roiScale = FLAGS_roi_scale;
+	config.maxRois = FLAGS_roi_max;
+	config.fullScanInterval = FLAGS_full_scan;
+	config.tileGrid = cv::Size(FLAGS_tile_cols, FLAGS_tile_rows);
+	config.tileOverlap = FLAGS_tile_overlap;
+	config.motionThreshold = FLAGS_motion;
+	config.escalationConfidence = FLAGS_esc_conf;
+	config.keypointRefill = FLAGS_refill;
+	return config;
+}
+
+Networks::Networks()
+	: faceDetector(FLAGS_m, FLAGS_d, FLAGS_b, FLAGS_b > 1, FLAGS_async, FLAGS_t, FLAGS_r, FLAGS_nireq),
+	escalationDetector(FLAGS_m_esc, FLAGS_d, FLAGS_b, FLAGS_b > 1, FLAGS_async, FLAGS_t, FLAGS_r, FLAGS_nireq,
+		"Escalation Face Detection"),
+	headPoseDetector(FLAGS_m_hp, FLAGS_d_hp, FLAGS_n_hp, FLAGS_dyn_hp, FLAGS_async, FLAGS_nireq),
+	landmarksDetector(FLAGS_m_lm, FLAGS_d_lm, FLAGS_n_lm, FLAGS_dyn_lm, FLAGS_async, FLAGS_nireq) {
+}
+
+void Networks::load() {
+	// Loading plugins to the Inference Engine, once per device
+	std::vector<std::pair<std::string, std::string>> cmdOptions = {
+		{FLAGS_d, FLAGS_m}, {FLAGS_d_hp, FLAGS_m_hp}, {FLAGS_d_lm, FLAGS_m_lm}
+	};
+	for (auto && option : cmdOptions) {
+		const std::string &deviceName = option.first;
+		if (deviceName.empty() || option.second.empty() || plugins.count(deviceName)) {
+			continue;
+		}
+		slog::info << "Loading plugin " << deviceName << slog::endl;
+		InferencePlugin plugin = PluginDispatcher({"../../../lib/intel64", ""}).getPluginByDevice(deviceName);
+
+		/** Printing plugin version **/
+		printPluginVersion(plugin, std::cout);
+
+		/** Loading extensions for the CPU plugin **/
+		if (deviceName.find("CPU") != std::string::npos) {
+			plugin.AddExtension(std::make_shared<Extensions::Cpu::CpuExtensions>());
+			if (!FLAGS_l.empty()) {
+				// CPU(MKLDNN) extensions are loaded as a shared library and passed as a pointer to base extension
+				plugin.AddExtension(make_so_pointer<IExtension>(FLAGS_l));
+				slog::info << "CPU Extension loaded: " << FLAGS_l << slog::endl;
+			}
+		} else if (!FLAGS_c.empty()) {
+			// Loading extensions for other plugins not CPU
+			plugin.SetConfig({{PluginConfigParams::KEY_CONFIG_FILE, FLAGS_c}});
+		}
+
+		/** Per-layer metrics **/
+		if (FLAGS_pc) {
+			plugin.SetConfig({{PluginConfigParams::KEY_PERF_COUNT, PluginConfigParams::YES}});
+		}
+		plugins[deviceName] = plugin;
+	}
+
+	// Reading IR models and loading them to plugins
+	// Dynamic batching lets frames of several streams share one face detection request
+	NetworkCache networkCache(FLAGS_cache_dir);
+	LoadDetector(faceDetector, &networkCache).into(plugins[FLAGS_d], FLAGS_b > 1);
+	// The escalation network shares the plugin of the face detection one
+	LoadDetector(escalationDetector, &networkCache).into(plugins[FLAGS_d], FLAGS_b > 1);
+	// Faces of all tracked frames waiting for analytics share one request of up to -n_hp/-n_lm faces
+	LoadDetector(headPoseDetector, &networkCache).into(plugins[FLAGS_d_hp], FLAGS_dyn_hp);
+	LoadDetector(landmarksDetector, &networkCache).into(plugins[FLAGS_d_lm], FLAGS_dyn_lm);
+}
+
+void Networks::printPerformanceCounts() {
+	faceDetector.printPerformanceCounts();
+	escalationDetector.printPerformanceCounts();
+	headPoseDetector.printPerformanceCounts();
+	landmarksDetector.printPerformanceCounts();
+}
@@ -2,17 +2,27 @@
 
 #include "platform.hpp"
 #include <gflags/gflags.h>
+#include "face_detector.hpp"
+#include "head_pose_detector.hpp"
+#include "landmarks_detector.hpp"
+#include "pipeline.hpp"
 
 /// @brief Message for help argument
 static const char help_message[] = "Print a usage message";
 
 /// @brief Message for images argument
-static const char video_message[] = "Optional. Path to a video file. Default value is \"cam\" to work with camera.";
+static const char video_message[] = "Optional. Comma-separated list of video files, cameras (\"cam\" or \"cam<index>\"), " \
+"generated frames (\"synthetic[:<width>x<height>[:<frames>]]\") or raw frame files written by cam_stream_record " \
+"(\"raw:<path>\" at the recorded pace, \"rawfast:<path>\" as fast as processed), processed in one process " \
+"with a shared detector. " \
+"Default value is \"cam\" to work with camera.";
 
 /// @brief message for model argument
 static const char face_detection_model_message[] = "Required. Path to an .xml file with a trained Face Detection model.";
 static const char head_pose_model_message[] = "Optional. Path to an .xml file with a trained Head Pose Estimation model.";
 static const char facial_landmarks_model_message[] = "Optional. Path to an .xml file with a trained Facial Landmarks Estimation model.";
+static const char escalation_model_message[] = "Optional. Path to an .xml file with a larger Face Detection model run on the -d device " \
+"for periodic full scans and after lost, missed or low confidence faces, while the -m model runs the routine re-detections.";
 
 /// @brief Message for plugin argument
 static const char plugin_message[] = "Plugin name. For example, CPU. If this parameter is specified, " \
@@ -68,77 +78,143 @@ static const char no_show_processed_video[] = "Do not show processed video.";
 /// @brief Message for asynchronous mode
 static const char async_message[] = "Enable asynchronous mode";
 
+/// @brief Message for the number of infer requests
+static const char nireq_message[] = "Number of infer requests kept in flight in asynchronous mode by each network: face " \
+"detection, escalation, head pose and facial landmarks. CPU plugin gets the same number of throughput streams " \
+"per network (default is 1)";
 
-/// \brief Define flag for showing help message<br>
-DEFINE_bool(h, false, help_message);
-
-/// \brief Define parameter for set image file<br>
-/// It is a required parameter
-DEFINE_string(i, "cam", video_message);
-
-/// \brief Define parameter for Face Detection model file<br>
-/// It is a required parameter
-DEFINE_string(m, "", face_detection_model_message);
-
-/// \brief Define parameter for Face Detection  model file<br>
-/// It is a required parameter
-DEFINE_string(m_hp, "", head_pose_model_message);
-
-/// \brief Define parameter for Facial Landmarks Estimation model file<br>
-/// It is an optional parameter
-DEFINE_string(m_lm, "", facial_landmarks_model_message);
-
-/// \brief target device for Face Detection network<br>
-DEFINE_string(d, "CPU", target_device_message);
-
-/// \brief Define parameter for target device for Head Pose Estimation network<br>
-DEFINE_string(d_hp, "CPU", target_device_message_hp);
-
-/// \brief Define parameter for target device for Facial Landmarks Estimation network<br>
-DEFINE_string(d_lm, "CPU", target_device_message_lm);
-
-/// \brief Define parameter for maximum batch size for Head Pose Estimation network<br>
-DEFINE_uint32(n_hp, 16, num_batch_hp_message);
-
-/// \brief Define parameter to enable dynamic batch size for Head Pose Estimation network<br>
-DEFINE_bool(dyn_hp, false, dyn_batch_hp_message);
-
-/// \brief Define parameter for maximum batch size for Facial Landmarks Estimation network<br>
-DEFINE_uint32(n_lm, 16, num_batch_lm_message);
-
-/// \brief Define parameter to enable dynamic batch size for Facial Landmarks Estimation network<br>
-DEFINE_bool(dyn_lm, false, dyn_batch_lm_message);
-
-/// \brief Define parameter to enable per-layer performance report<br>
-DEFINE_bool(pc, false, performance_counter_message);
-
-/// @brief Define parameter for GPU custom kernels path<br>
-/// Default is ./lib
-DEFINE_string(c, "", custom_cldnn_message);
-
-/// @brief Define parameter for absolute path to CPU library with user layers<br>
-/// It is an optional parameter
-DEFINE_string(l, "", custom_cpu_library_message);
-
-/// \brief Define a flag to output raw scoring results<br>
-/// It is an optional parameter
-DEFINE_bool(r, false, raw_output_message);
-
-/// \brief Define a parameter for probability threshold for detections<br>
-/// It is an optional parameter
-DEFINE_double(t, 0.5, thresh_output_message);
-
-/// \brief Define a flag to disable keypress exit<br>
-/// It is an optional parameter
-DEFINE_bool(no_wait, false, no_wait_for_keypress_message);
-
-/// \brief Define a flag to disable showing processed video<br>
-/// It is an optional parameter
-DEFINE_bool(no_show, false, no_show_processed_video);
-
-/// \brief Define a flag to enable aynchronous execution<br>
-/// It is an optional parameter
-DEFINE_bool(async, false, async_message);
+/// @brief Message for the minimum detection interval
+static const char det_min_message[] = "Minimum number of frames between face detections (default is 5)";
+
+/// @brief Message for the maximum detection interval
+static const char det_max_message[] = "Maximum number of frames between face detections (default is 60)";
+
+/// @brief Message for the drift tolerance
+static const char drift_message[] = "Tolerated drift of tracked faces relative to the face size before a new detection " \
+"is scheduled (default is 0.15)";
+
+/// @brief Message for the catch-up buffer size
+static const char catchup_frames_message[] = "Maximum number of frames kept for replaying a detection in flight (default is 64)";
+
+/// @brief Message for the catch-up buffer memory limit
+static const char catchup_mb_message[] = "Memory limit in MB of the frames kept for replaying a detection in flight. " \
+"Every second frame is dropped when it is reached (default is 64)";
+
+/// @brief Message for the catch-up time budget
+static const char catchup_ms_message[] = "Time budget in ms per frame for replaying a finished detection up to the live frame " \
+"(default is 2)";
+
+/// @brief Message for the maximum batch size of the face detector
+static const char num_batch_message[] = "Maximum number of frames from different streams processed in one " \
+"Face Detection request with dynamic batching (default is 1)";
+
+/// @brief Message for the batch wait time
+static const char batch_wait_message[] = "Longest time in ms a partially filled Face Detection batch waits " \
+"for frames from other streams (default is 5)";
+
+/// @brief Message for the number of tracking threads
+static const char nthreads_message[] = "Number of tracking threads shared by all input streams " \
+"(default is 0, one per stream up to the number of hardware threads)";
+
+/// @brief Message for the capacity of the queues between pipeline stages
+static const char queue_message[] = "Number of frames queued between processing stages (default is 4)";
+
+/// @brief Message for the size of the re-detected regions around tracks
+static const char roi_scale_message[] = "Size of the regions around tracked faces that detections between full scans run on, " \
+"relative to the face size (default is 0, every detection scans the full frame)";
+
+/// @brief Message for the number of regions of one re-detection
+static const char roi_max_message[] = "Most regions of one re-detection, frames with more tracked faces get a full scan (default is 2)";
+
+/// @brief Message for the interval of full frame scans
+static const char full_scan_message[] = "Every N-th detection of a stream scans the full frame for new faces when -roi_scale is set (default is 4)";
+
+/// @brief Message for the tile grid of full scans
+static const char tile_cols_message[] = "Columns of overlapping tiles a full frame scan is split into, all tiles of a frame share " \
+"one batched request when -b is at least the number of tiles (default is 1)";
+static const char tile_rows_message[] = "Rows of overlapping tiles a full frame scan is split into (default is 1)";
+
+/// @brief Message for the overlap of neighbouring tiles
+static const char tile_overlap_message[] = "Overlap of neighbouring tiles relative to the tile size (default is 0.15)";
+
+/// @brief Message for the motion gate threshold
+static const char motion_message[] = "Mean gray level change of an image block for a frame to count as moved, frames without motion " \
+"skip tracking and detection (default is 0, every frame is processed)";
+
+/// @brief Message for the escalation confidence
+static const char esc_conf_message[] = "Confidence below which a face found by the -m model escalates the next detection " \
+"to the -m_esc model (default is 0.7)";
+
+/// @brief Message for the keypoint refill
+static const char refill_message[] = "Share of the keypoints per face below which a track gets new keypoints inside its box " \
+"between detections, 0 to refill only on detections (default is 0.5)";
+
+/// @brief Message for the display rate
+static const char show_fps_message[] = "Most frames shown per second and stream, independent of the processing rate (default is 30)";
+
+/// @brief Message for the compiled network cache
+static const char cache_dir_message[] = "Optional. Directory of compiled networks, a network found there is imported " \
+"instead of compiled on devices that support it. Not cached when not set.";
+
+/// @brief Message for the result output
+static const char out_message[] = "Optional. Per-frame track records: shm:<name>[:<records>] for a shared memory ring, " \
+"unix:<path> for datagrams to a Unix socket, or the path of a JSON-lines file (\"-\" for stdout)";
+
+/// @brief Message for the trace output path
+static const char trace_message[] = "Optional. Path to a Chrome trace JSON file with the spans of every frame, " \
+"written on exit or on SIGUSR1. Tracing is off when not set.";
+
+/// @brief Message for the trace ring capacity
+static const char trace_events_message[] = "Number of most recent spans kept for the trace (default is 262144)";
+
+
+// Flags are defined once in cam_stream.cpp, shared by the demo and the benchmark
+DECLARE_bool(h);
+DECLARE_string(i);
+DECLARE_string(m);
+DECLARE_string(m_hp);
+DECLARE_string(m_lm);
+DECLARE_string(m_esc);
+DECLARE_string(d);
+DECLARE_string(d_hp);
+DECLARE_string(d_lm);
+DECLARE_uint32(n_hp);
+DECLARE_bool(dyn_hp);
+DECLARE_uint32(n_lm);
+DECLARE_bool(dyn_lm);
+DECLARE_bool(pc);
+DECLARE_string(c);
+DECLARE_string(l);
+DECLARE_bool(r);
+DECLARE_double(t);
+DECLARE_bool(no_wait);
+DECLARE_bool(no_show);
+DECLARE_bool(async);
+DECLARE_uint32(nireq);
+DECLARE_uint32(det_min);
+DECLARE_uint32(det_max);
+DECLARE_double(drift);
+DECLARE_uint32(catchup_frames);
+DECLARE_uint32(catchup_mb);
+DECLARE_double(catchup_ms);
+DECLARE_uint32(b);
+DECLARE_double(batch_wait);
+DECLARE_uint32(nthreads);
+DECLARE_uint32(queue);
+DECLARE_double(roi_scale);
+DECLARE_uint32(roi_max);
+DECLARE_uint32(full_scan);
+DECLARE_uint32(tile_cols);
+DECLARE_uint32(tile_rows);
+DECLARE_double(tile_overlap);
+DECLARE_double(motion);
+DECLARE_double(esc_conf);
+DECLARE_double(refill);
+DECLARE_double(show_fps);
+DECLARE_string(cache_dir);
+DECLARE_string(out);
+DECLARE_string(trace);
+DECLARE_uint32(trace_events);
 
 /**
 * \brief This function shows a help message
@@ -154,6 +230,7 @@ static void showUsage() {
     std::cout << "    -m \"<path>\"                " << face_detection_model_message<< std::endl;
     std::cout << "    -m_hp \"<path>\"             " << head_pose_model_message << std::endl;
     std::cout << "    -m_lm \"<path>\"             " << facial_landmarks_model_message << std::endl;
+    std::cout << "    -m_esc \"<path>\"            " << escalation_model_message << std::endl;
     std::cout << "      -l \"<absolute_path>\"     " << custom_cpu_library_message << std::endl;
     std::cout << "          Or" << std::endl;
     std::cout << "      -c \"<absolute_path>\"     " << custom_cldnn_message << std::endl;
@@ -165,9 +242,57 @@ static void showUsage() {
     std::cout << "    -dyn_hp                    " << dyn_batch_hp_message << std::endl;
     std::cout << "    -dyn_lm                    " << dyn_batch_lm_message << std::endl;
     std::cout << "    -async                     " << async_message << std::endl;
+    std::cout << "    -nireq \"<num>\"             " << nireq_message << std::endl;
+    std::cout << "    -det_min \"<num>\"           " << det_min_message << std::endl;
+    std::cout << "    -det_max \"<num>\"           " << det_max_message << std::endl;
+    std::cout << "    -drift \"<value>\"           " << drift_message << std::endl;
+    std::cout << "    -catchup_frames \"<num>\"    " << catchup_frames_message << std::endl;
+    std::cout << "    -catchup_mb \"<num>\"        " << catchup_mb_message << std::endl;
+    std::cout << "    -catchup_ms \"<value>\"      " << catchup_ms_message << std::endl;
+    std::cout << "    -b \"<num>\"                 " << num_batch_message << std::endl;
+    std::cout << "    -batch_wait \"<value>\"      " << batch_wait_message << std::endl;
+    std::cout << "    -nthreads \"<num>\"          " << nthreads_message << std::endl;
+    std::cout << "    -queue \"<num>\"             " << queue_message << std::endl;
+    std::cout << "    -roi_scale \"<value>\"       " << roi_scale_message << std::endl;
+    std::cout << "    -roi_max \"<num>\"           " << roi_max_message << std::endl;
+    std::cout << "    -full_scan \"<num>\"         " << full_scan_message << std::endl;
+    std::cout << "    -tile_cols \"<num>\"         " << tile_cols_message << std::endl;
+    std::cout << "    -tile_rows \"<num>\"         " << tile_rows_message << std::endl;
+    std::cout << "    -tile_overlap \"<value>\"    " << tile_overlap_message << std::endl;
+    std::cout << "    -motion \"<value>\"          " << motion_message << std::endl;
+    std::cout << "    -esc_conf \"<value>\"        " << esc_conf_message << std::endl;
+    std::cout << "    -refill \"<value>\"          " << refill_message << std::endl;
+    std::cout << "    -cache_dir \"<path>\"        " << cache_dir_message << std::endl;
+    std::cout << "    -out \"<spec>\"              " << out_message << std::endl;
+    std::cout << "    -trace \"<path>\"            " << trace_message << std::endl;
+    std::cout << "    -trace_events \"<num>\"      " << trace_events_message << std::endl;
     std::cout << "    -no_wait                   " << no_wait_for_keypress_message << std::endl;
     std::cout << "    -no_show                   " << no_show_processed_video << std::endl;
+    std::cout << "    -show_fps \"<value>\"        " << show_fps_message << std::endl;
     std::cout << "    -pc                        " << performance_counter_message << std::endl;
     std::cout << "    -r                         " << raw_output_message << std::endl;
     std::cout << "    -t                         " << thresh_output_message << std::endl;
 }
+
+/** Checks the flags shared by the demo and the benchmark, throws std::logic_error on invalid values **/
+void checkFlags();
+/** Non-empty entries of the comma-separated -i list **/
+std::vector<std::string> sourcesFromFlags();
+PipelineConfig pipelineConfigFromFlags();
+
+/**
+* Networks named by the flags. load() loads the plugin of every device in use once and the
+* networks into them, through the compiled network cache when -cache_dir is set.
+**/
+struct Networks {
+	/** Declared first so the plugins outlive the networks loaded into them **/
+	std::map<std::string, InferenceEngine::InferencePlugin> plugins;
+	FaceDetector faceDetector;
+	FaceDetector escalationDetector;
+	HeadPoseDetector headPoseDetector;
+	FacialLandmarksDetector landmarksDetector;
+
+	Networks();
+	void load();
+	void printPerformanceCounts();
+};
@@ -0,0 +1,48 @@
+#include "platform.hpp"
+#include "catch_up.hpp"
+
+CatchUp::CatchUp(double budgetMs, size_t capacity, size_t maxBytes)
+	: budgetMs(budgetMs), frames(capacity, maxBytes), _active(false) {
+}
+
+void CatchUp::start(std::vector<Track> candidates, const FrameBuffer &buffered) {
+	this->candidates = std::move(candidates);
+	frames.clear();
+	for (size_t i = 0; i < buffered.size(); i++) {
+		frames.push(buffered[i]);
+	}
+	_active = true;
+}
+
+void CatchUp::push(const FramePtr &frame) {
+	if (_active) {
+		frames.push(frame);
+	}
+}
+
+bool CatchUp::step(const Tracker &tracker) {
+	if (!_active) return false;
+
+	// At least two frame pairs per call, so the replay always gains on the live frames
+	const int minSteps = 2;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int steps = 0; frames.size() > 1; steps++) {
+		if (steps >= minSteps) {
+			std::chrono::duration<double, std::milli> spent = std::chrono::high_resolution_clock::now() - start;
+			if (spent.count() >= budgetMs) break;
+		}
+		tracker.track(candidates, *frames[0], *frames[1]);
+		frames.popFront();
+	}
+	return frames.size() <= 1;
+}
+
+void CatchUp::finish() {
+	candidates.clear();
+	frames.clear();
+	_active = false;
+}
+
+bool CatchUp::active() const {
+	return _active;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "platform.hpp"
+#include "frame_buffer.hpp"
+#include "tracker.hpp"
+
+/**
+* Brings freshly detected faces from the frame the detection ran on up to the live frame.
+* The replay is spread over the following frames within a per-frame time budget instead
+* of running over all buffered frames at once.
+**/
+struct CatchUp {
+	const double budgetMs;
+	FrameBuffer frames;
+	std::vector<Track> candidates;
+
+	CatchUp(double budgetMs, size_t capacity, size_t maxBytes);
+
+	/** Starts replaying candidates over a copy of the buffered frames, dropping an unfinished replay **/
+	void start(std::vector<Track> candidates, const FrameBuffer &buffered);
+	/** Appends a live frame the candidates have to reach **/
+	void push(const FramePtr &frame);
+	/** Replays buffered frames within the budget, returns true when candidates reached the newest frame **/
+	bool step(const Tracker &tracker);
+	void finish();
+	bool active() const;
+
+private:
+	bool _active;
+};
@@ -0,0 +1,41 @@
+#include "platform.hpp"
+#include "detection_scheduler.hpp"
+
+DetectionScheduler::DetectionScheduler(int minInterval, int maxInterval, double driftTolerance, int fullScanInterval)
+	: minInterval(std::max(minInterval, 1)), maxInterval(std::max(maxInterval, minInterval)),
+	driftTolerance(driftTolerance), fullScanInterval(std::max(fullScanInterval, 1)),
+	framesSinceDetection(this->maxInterval), detectionsSinceFullScan(this->fullScanInterval),
+	driftVariance(0.0), tracksLost(false) {
+}
+
+void DetectionScheduler::update(const TrackerHealth &health) {
+	framesSinceDetection++;
+
+	// Per-frame tracking errors are treated as independent, so they add up like a random walk.
+	// Keypoints failing the forward-backward check count as an error of the same relative size.
+	double frameError = health.flowSpread + (1.0 - health.survivalRatio());
+	driftVariance += frameError * frameError;
+
+	tracksLost = tracksLost || health.lostTracks > 0;
+}
+
+double DetectionScheduler::drift() const {
+	return std::sqrt(driftVariance);
+}
+
+bool DetectionScheduler::shouldDetect() const {
+	if (framesSinceDetection >= maxInterval) return true;
+	if (framesSinceDetection < minInterval) return false;
+	return tracksLost || drift() >= driftTolerance;
+}
+
+bool DetectionScheduler::fullScanDue() const {
+	return detectionsSinceFullScan + 1 >= fullScanInterval;
+}
+
+void DetectionScheduler::detectionSubmitted(bool fullScan) {
+	detectionsSinceFullScan = fullScan ? 0 : detectionsSinceFullScan + 1;
+	framesSinceDetection = 0;
+	driftVariance = 0.0;
+	tracksLost = false;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "platform.hpp"
+#include "tracker.hpp"
+
+struct DetectionScheduler {
+	const int minInterval;
+	const int maxInterval;
+	const double driftTolerance;
+	/** Every fullScanInterval-th detection scans the whole frame, the others only the track regions **/
+	const int fullScanInterval;
+	int framesSinceDetection;
+	int detectionsSinceFullScan;
+	double driftVariance;
+	bool tracksLost;
+
+	/** The first frame is always due for detection **/
+	DetectionScheduler(int minInterval, int maxInterval, double driftTolerance, int fullScanInterval = 1);
+
+	/** Accumulates the drift estimate from the health of the last tracked frame **/
+	void update(const TrackerHealth &health);
+	/** Estimated drift of the track boxes since the last detection, relative to the face size **/
+	double drift() const;
+	bool shouldDetect() const;
+	/** Whether the next detection has to look for new faces in the whole frame **/
+	bool fullScanDue() const;
+	void detectionSubmitted(bool fullScan = true);
+};
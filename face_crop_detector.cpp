@@ -0,0 +1,70 @@
+#include "platform.hpp"
+#include "face_crop_detector.hpp"
+
+using namespace InferenceEngine;
+
+FaceCropDetector::FaceCropDetector(std::string topoName,
+	const std::string &pathToModel,
+	const std::string &deviceForInference,
+	int maxBatch, bool isBatchDynamic, bool isAsync, int numRequests)
+	: BaseDetector(topoName, pathToModel, deviceForInference, maxBatch, isBatchDynamic, isAsync, numRequests),
+	enquedFaces(0) {
+}
+
+void FaceCropDetector::createRequests() {
+	BaseDetector::createRequests();
+	faceRects.assign(requests.size(), std::vector<cv::Rect>());
+	inputBlobs.clear();
+	for (auto &request : requests) {
+		inputBlobs.push_back(request.request->GetBlob(input));
+	}
+}
+
+void FaceCropDetector::submitRequest() {
+	if (!enquedFaces) return;
+	if (isBatchDynamic) {
+		requests[currentRequest()].request->SetBatch(enquedFaces);
+	}
+	enquedFaces = 0;
+	BaseDetector::submitRequest();
+}
+
+void FaceCropDetector::enqueue(const cv::Mat &frame, const cv::Rect &face, size_t faceId) {
+	if (!enabled()) return;
+	if (enquedFaces >= maxBatch) {
+		throw std::logic_error(topoName + " batch is already full");
+	}
+	// Enlarged boxes of faces at the frame border reach outside of it
+	const cv::Rect roi = face & cv::Rect(cv::Point(), frame.size());
+	if (roi.area() <= 0) {
+		throw std::logic_error(topoName + " face region is outside of the frame");
+	}
+
+	int index = currentRequest();
+	if (!enquedFaces) {
+		requests[index].frameIds.clear();
+		faceRects[index].clear();
+	}
+	requests[index].frameIds.push_back(faceId);
+	faceRects[index].push_back(roi);
+
+	uint8_t *slot = inputBlobs[index]->buffer().as<uint8_t *>() + enquedFaces * inputSize.area() * 3;
+	cv::Mat slotImage(inputSize, CV_8UC3, slot);
+	cv::resize(frame(roi), slotImage, inputSize);
+	enquedFaces++;
+}
+
+void FaceCropDetector::readInput(CNNNetwork &network) {
+	slog::info << "Checking " << topoName << " network inputs" << slog::endl;
+	InputsDataMap inputInfo(network.getInputsInfo());
+	if (inputInfo.size() != 1) {
+		throw std::logic_error(topoName + " network should have only one input");
+	}
+	InputInfo::Ptr inputInfoFirst = inputInfo.begin()->second;
+	inputInfoFirst->setPrecision(Precision::U8);
+	// Faces are resized into interleaved BGR slots, the plugin converts the layout
+	inputInfoFirst->setLayout(Layout::NHWC);
+	const SizeVector inputDims = inputInfoFirst->getTensorDesc().getDims();
+	inputSize = cv::Size(static_cast<int>(inputDims[3]), static_cast<int>(inputDims[2]));
+	input = inputInfo.begin()->first;
+}
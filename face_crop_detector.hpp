@@ -0,0 +1,36 @@
+#pragma once
+
+#include "platform.hpp"
+#include "base_detector.hpp"
+
+/**
+* Network run on face regions. Faces of one or several frames share a batched request: every
+* face is resized from a view into its frame straight into its slot of the request's input blob,
+* so no crop is copied on the way.
+**/
+struct FaceCropDetector : BaseDetector {
+	std::string input;
+	int enquedFaces;
+	cv::Size inputSize;
+	std::vector<InferenceEngine::Blob::Ptr> inputBlobs;
+
+	FaceCropDetector(std::string topoName,
+		const std::string &pathToModel,
+		const std::string &deviceForInference,
+		int maxBatch, bool isBatchDynamic, bool isAsync, int numRequests = 1);
+
+	void createRequests() override;
+	void submitRequest() override;
+
+	/** Adds the face region of the frame to the batch of the request being filled **/
+	void enqueue(const cv::Mat &frame, const cv::Rect &face, size_t faceId);
+	/** Reads results of a completed request per batch image and releases the request **/
+	virtual void fetchResults(int request) = 0;
+
+protected:
+	/** Face boxes of the batch images of every request, clipped to their frames **/
+	std::vector<std::vector<cv::Rect>> faceRects;
+
+	/** Checks that the network has a single input and declares it as interleaved U8 **/
+	void readInput(InferenceEngine::CNNNetwork &network);
+};
@@ -6,35 +6,76 @@ using namespace InferenceEngine;
 FaceDetector::FaceDetector(const std::string &pathToModel,
 	const std::string &deviceForInference,
 	int maxBatch, bool isBatchDynamic, bool isAsync,
-	double detectionThreshold, bool doRawOutputMessages)
-	: BaseDetector("Face Detection", pathToModel, deviceForInference, maxBatch, isBatchDynamic, isAsync),
+	double detectionThreshold, bool doRawOutputMessages, int numRequests, const std::string &topoName)
+	: BaseDetector(topoName, pathToModel, deviceForInference, maxBatch, isBatchDynamic, isAsync, numRequests),
 	detectionThreshold(detectionThreshold), doRawOutputMessages(doRawOutputMessages),
-	enquedFrames(0), width(0), height(0), bb_enlarge_coefficient(1.2), resultsFetched(false) {
+	enquedFrames(0), bb_enlarge_coefficient(1.2),
+	decoder(static_cast<float>(detectionThreshold), bb_enlarge_coefficient) {
+}
+
+void FaceDetector::createRequests() {
+	BaseDetector::createRequests();
+	frameSizes.assign(requests.size(), std::vector<cv::Size>());
+	frameOffsets.assign(requests.size(), std::vector<cv::Point>());
+	inputFrames.assign(requests.size(), std::vector<cv::Mat>());
+	inputBlobs.clear();
+	for (auto &request : requests) {
+		inputBlobs.push_back(request.request->GetBlob(input));
+	}
 }
 
 void FaceDetector::submitRequest() {
 	if (!enquedFrames) return;
+	if (isBatchDynamic) {
+		requests[currentRequest()].request->SetBatch(enquedFrames);
+	}
 	enquedFrames = 0;
-	resultsFetched = false;
-	results.clear();
 	BaseDetector::submitRequest();
 }
 
-void FaceDetector::enqueue(const cv::Mat &frame) {
-	if (!enabled()) return;
+void FaceDetector::enqueue(const cv::Mat &frame, size_t frameId) {
+	enqueue(frame, cv::Rect(cv::Point(), frame.size()), frameId);
+}
 
-	if (!request) {
-		request = net.CreateInferRequestPtr();
+void FaceDetector::enqueue(const cv::Mat &frame, const cv::Rect &roi, size_t frameId) {
+	if (!enabled()) return;
+	if (enquedFrames >= maxBatch) {
+		throw std::logic_error("Face Detection batch is already full");
 	}
 
-	width = frame.cols;
-	height = frame.rows;
-
-	Blob::Ptr  inputBlob = request->GetBlob(input);
-
-	matU8ToBlob<uint8_t>(frame, inputBlob);
-
-	enquedFrames = 1;
+	int index = currentRequest();
+	if (!enquedFrames) {
+		requests[index].frameIds.clear();
+		frameSizes[index].clear();
+		frameOffsets[index].clear();
+		inputFrames[index].clear();
+	}
+	// View into the frame, the region is never copied on its own
+	const cv::Rect region = roi & cv::Rect(cv::Point(), frame.size());
+	const cv::Mat image = frame(region);
+	requests[index].frameIds.push_back(frameId);
+	frameSizes[index].push_back(image.size());
+	frameOffsets[index].push_back(region.tl());
+
+	InferRequest::Ptr &request = requests[index].request;
+	if (maxBatch == 1 && image.isContinuous() && pluginPreprocessing) {
+		// Wrap the frame without copying, it stays referenced until the request is fetched
+		inputFrames[index].push_back(image);
+		TensorDesc frameDesc(Precision::U8,
+			{1, static_cast<size_t>(image.channels()), static_cast<size_t>(image.rows), static_cast<size_t>(image.cols)},
+			Layout::NHWC);
+		request->SetBlob(input, make_shared_blob<uint8_t>(frameDesc, image.data));
+	} else {
+		// Single resize pass straight into the interleaved batch slot
+		Blob::Ptr &inputBlob = inputBlobs[index];
+		if (request->GetBlob(input) != inputBlob) {
+			request->SetBlob(input, inputBlob);
+		}
+		uint8_t *slot = inputBlob->buffer().as<uint8_t *>() + enquedFrames * inputSize.area() * 3;
+		cv::Mat slotImage(inputSize, CV_8UC3, slot);
+		cv::resize(image, slotImage, inputSize);
+	}
+	enquedFrames++;
 }
 
 CNNNetwork FaceDetector::read() {
@@ -42,7 +83,7 @@ CNNNetwork FaceDetector::read() {
 	CNNNetReader netReader;
 	/** Read network model **/
 	netReader.ReadNetwork(pathToModel);
-	/** Set batch size to 1 **/
+	/** Set the maximum batch size, dynamic batching may run less **/
 	slog::info << "Batch size is set to " << maxBatch << slog::endl;
 	netReader.getNetwork().setBatchSize(maxBatch);
 	/** Extract model name and load its weights **/
@@ -66,6 +107,11 @@ CNNNetwork FaceDetector::read() {
 	}
 	InputInfo::Ptr inputInfoFirst = inputInfo.begin()->second;
 	inputInfoFirst->setPrecision(Precision::U8);
+	// Frames are passed as interleaved BGR of any size, the plugin resizes and converts the layout
+	inputInfoFirst->setLayout(Layout::NHWC);
+	inputInfoFirst->getPreProcess().setResizeAlgorithm(ResizeAlgorithm::RESIZE_BILINEAR);
+	const SizeVector inputDims = inputInfoFirst->getTensorDesc().getDims();
+	inputSize = cv::Size(static_cast<int>(inputDims[3]), static_cast<int>(inputDims[2]));
 	// -----------------------------------------------------------------------------------------------------
 
 	// ---------------------------Check outputs ------------------------------------------------------------
@@ -98,7 +144,7 @@ CNNNetwork FaceDetector::read() {
 	const SizeVector outputDims = _output->getTensorDesc().getDims();
 	maxProposalCount = outputDims[2];
 	objectSize = outputDims[3];
-	if (objectSize != 7) {
+	if (objectSize != SsdDecoder::objectSize) {
 		throw std::logic_error("Face Detection network output layer should have 7 as a last dimension");
 	}
 	if (outputDims.size() != 4) {
@@ -112,56 +158,66 @@ CNNNetwork FaceDetector::read() {
 	return netReader.getNetwork();
 }
 
-void FaceDetector::fetchResults() {
+void FaceDetector::fetchResults(int request) {
 	if (!enabled()) return;
-	results.clear();
-	if (resultsFetched) return;
-	resultsFetched = true;
-	const float *detections = request->GetBlob(output)->buffer().as<float *>();
+	const std::vector<cv::Size> &sizes = frameSizes[request];
+	const std::vector<cv::Point> &offsets = frameOffsets[request];
+	resultsFrameIds = requests[request].frameIds;
+	// Per-image vectors keep their capacity between requests
+	results.resize(sizes.size());
+	for (auto &imageResults : results) {
+		imageResults.clear();
+	}
+	const float *detections = requests[request].request->GetBlob(output)->buffer().as<float *>();
 
-	for (int i = 0; i < maxProposalCount; i++) {
-		float image_id = detections[i * objectSize + 0];
+	// Make square and enlarge face bounding box for more robust operation of face analytics networks
+	decoder.decode(detections, maxProposalCount, sizes, decoded);
+
+	for (size_t i = 0; i < decoded.size(); i++) {
 		Result r;
-		r.label = static_cast<int>(detections[i * objectSize + 1]);
-		r.confidence = detections[i * objectSize + 2];
+		r.label = decoded.label[i];
+		r.confidence = decoded.conf[i];
+		r.location = cv::Rect(cvRound(decoded.x[i]), cvRound(decoded.y[i]), cvRound(decoded.w[i]), cvRound(decoded.h[i]));
+		r.location += offsets[decoded.image_id[i]];
 
-		if (r.confidence <= detectionThreshold) {
-			continue;
+		if (doRawOutputMessages) {
+			std::cout << "[" << decoded.image_id[i] << "," << r.label << "] element, prob = " << r.confidence <<
+				"    (" << r.location.x << "," << r.location.y << ")-(" << r.location.width << ","
+				<< r.location.height << ")" << std::endl;
 		}
 
-		r.location.x = detections[i * objectSize + 3] * width;
-		r.location.y = detections[i * objectSize + 4] * height;
-		r.location.width = detections[i * objectSize + 5] * width - r.location.x;
-		r.location.height = detections[i * objectSize + 6] * height - r.location.y;
-
-		// Make square and enlarge face bounding box for more robust operation of face analytics networks
-		int bb_width = r.location.width;
-		int bb_height = r.location.height;
-
-		int bb_center_x = r.location.x + bb_width / 2;
-		int bb_center_y = r.location.y + bb_height / 2;
-
-		int max_of_sizes = std::max(bb_width, bb_height);
-
-		int bb_new_width = bb_enlarge_coefficient * max_of_sizes;
-		int bb_new_height = bb_enlarge_coefficient * max_of_sizes;
-
-		r.location.x = bb_center_x - bb_new_width / 2;
-		r.location.y = bb_center_y - bb_new_height / 2;
+		results[decoded.image_id[i]].push_back(r);
+	}
+	inputFrames[request].clear();
+	releaseRequest(request);
+}
 
-		r.location.width = bb_new_width;
-		r.location.height = bb_new_height;
+float intersectionOverUnion(const cv::Rect &a, const cv::Rect &b) {
+	const float intersection = static_cast<float>((a & b).area());
+	if (intersection <= 0) return 0.f;
+	return intersection / (a.area() + b.area() - intersection);
+}
 
-		if (image_id < 0) {
-			break;
+void suppressOverlaps(std::vector<FaceDetector::Result> &results, float overlapThreshold) {
+	std::sort(results.begin(), results.end(),
+		[](const FaceDetector::Result &a, const FaceDetector::Result &b) { return a.confidence > b.confidence; });
+	std::vector<FaceDetector::Result> kept;
+	for (auto &result : results) {
+		bool overlaps = false;
+		for (auto &better : kept) {
+			const cv::Rect &a = result.location;
+			const cv::Rect &b = better.location;
+			// Cheap rejection first, most pairs of a frame do not touch at all
+			if (a.x >= b.x + b.width || b.x >= a.x + a.width || a.y >= b.y + b.height || b.y >= a.y + a.height) continue;
+			const float intersection = static_cast<float>((a & b).area());
+			if (intersection > overlapThreshold * std::min(a.area(), b.area())) {
+				overlaps = true;
+				break;
+			}
 		}
-		if (doRawOutputMessages) {
-			std::cout << "[" << i << "," << r.label << "] element, prob = " << r.confidence <<
-				"    (" << r.location.x << "," << r.location.y << ")-(" << r.location.width << ","
-				<< r.location.height << ")"
-				<< ((r.confidence > detectionThreshold) ? " WILL BE RENDERED!" : "") << std::endl;
+		if (!overlaps) {
+			kept.push_back(result);
 		}
-
-		results.push_back(r);
 	}
+	results.swap(kept);
 }
@@ -1,7 +1,8 @@
-#pragma once
-
-#include "platform.hpp"
-#include "base_detector.hpp"
+#pragma once
+
+#include "platform.hpp"
+#include "base_detector.hpp"
+#include "ssd_decoder.hpp"
 
 struct FaceDetector : BaseDetector {
 	struct Result {
@@ -17,21 +18,46 @@ struct FaceDetector : BaseDetector {
 	int maxProposalCount;
 	int objectSize;
 	int enquedFrames;
-	float width;
-	float height;
+	cv::Size inputSize;
+	std::vector<std::vector<cv::Size>> frameSizes;
+	/** Position of every batch image in its frame, results are moved back by it **/
+	std::vector<std::vector<cv::Point>> frameOffsets;
+	/** Frames referenced by the requests until they complete, and the requests' own input blobs **/
+	std::vector<std::vector<cv::Mat>> inputFrames;
+	std::vector<InferenceEngine::Blob::Ptr> inputBlobs;
 	const float bb_enlarge_coefficient;
-	bool resultsFetched;
+	SsdDecoder decoder;
+	DetectionBuffer decoded;
 	std::vector<std::string> labels;
-	std::vector<Result> results;
+	/** Results of the fetched request per batch image, with the frame ids the images were enqueued with **/
+	std::vector<std::vector<Result>> results;
+	std::vector<size_t> resultsFrameIds;
 
 	FaceDetector(const std::string &pathToModel,
 		const std::string &deviceForInference,
 		int maxBatch, bool isBatchDynamic, bool isAsync,
-		double detectionThreshold, bool doRawOutputMessages);
+		double detectionThreshold, bool doRawOutputMessages, int numRequests = 1,
+		const std::string &topoName = "Face Detection");
 
 	InferenceEngine::CNNNetwork read() override;
+	void createRequests() override;
 	void submitRequest() override;
 
-	void enqueue(const cv::Mat &frame);
-	void fetchResults();
+	/**
+	* Adds the frame to the batch of the request being filled. A single continuous frame is passed to
+	* the plugin as is and resized by its preprocessing, batched frames and frames of networks imported
+	* from the cache are resized into the input blob.
+	**/
+	void enqueue(const cv::Mat &frame, size_t frameId = 0);
+	/** Adds the region of the frame as a batch image, its results are in frame coordinates **/
+	void enqueue(const cv::Mat &frame, const cv::Rect &roi, size_t frameId);
+	/** Reads results of a completed request split per batch image and releases the request **/
+	void fetchResults(int request);
 };
+
+float intersectionOverUnion(const cv::Rect &a, const cv::Rect &b);
+/**
+* Drops results whose box overlaps the box of a more confident one by more than the threshold,
+* measured relative to the smaller box so that a partial face is dropped in favour of the whole one.
+**/
+void suppressOverlaps(std::vector<FaceDetector::Result> &results, float overlapThreshold);
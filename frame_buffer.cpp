@@ -0,0 +1,86 @@
+#include "platform.hpp"
+#include "frame_buffer.hpp"
+
+FrameBuffer::FrameBuffer(size_t capacity, size_t maxBytes)
+	: capacity(std::max<size_t>(capacity, 3)), maxBytes(maxBytes), decimations(0),
+	_slots(this->capacity), _slotBytes(this->capacity, 0), _head(0), _count(0), _bytes(0) {
+}
+
+void FrameBuffer::push(const FramePtr &frame) {
+	const size_t frameBytes = frame->bytes();
+	// The first and the newest frames are always kept, even above the memory limit
+	while (_count > 2 && (_count == capacity || _bytes + frameBytes > maxBytes)) {
+		decimate();
+	}
+	size_t s = slot(_count);
+	_slots[s] = frame;
+	_slotBytes[s] = frameBytes;
+	_bytes += frameBytes;
+	_count++;
+}
+
+void FrameBuffer::popFront() {
+	if (!_count) return;
+	_bytes -= _slotBytes[_head];
+	_slots[_head].reset();
+	_slotBytes[_head] = 0;
+	_head = (_head + 1) % capacity;
+	_count--;
+}
+
+void FrameBuffer::clear() {
+	while (_count) {
+		popFront();
+	}
+	_head = 0;
+}
+
+size_t FrameBuffer::size() const {
+	return _count;
+}
+
+bool FrameBuffer::empty() const {
+	return _count == 0;
+}
+
+size_t FrameBuffer::bytes() const {
+	return _bytes;
+}
+
+const FramePtr &FrameBuffer::operator[](size_t i) const {
+	return _slots[slot(i)];
+}
+
+const FramePtr &FrameBuffer::front() const {
+	return (*this)[0];
+}
+
+const FramePtr &FrameBuffer::back() const {
+	return (*this)[_count - 1];
+}
+
+size_t FrameBuffer::slot(size_t i) const {
+	return (_head + i) % capacity;
+}
+
+void FrameBuffer::decimate() {
+	// Keep the first and the last frames and every second one in between
+	size_t kept = 1;
+	for (size_t i = 1; i < _count; i++) {
+		size_t from = slot(i);
+		if (i % 2 == 0 || i == _count - 1) {
+			size_t to = slot(kept++);
+			if (to != from) {
+				_slots[to] = std::move(_slots[from]);
+				_slotBytes[to] = _slotBytes[from];
+				_slotBytes[from] = 0;
+			}
+		} else {
+			_bytes -= _slotBytes[from];
+			_slots[from].reset();
+			_slotBytes[from] = 0;
+		}
+	}
+	_count = kept;
+	decimations++;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "platform.hpp"
+#include "frame_context.hpp"
+
+/**
+* Fixed-capacity ring of the frames a detection in flight has to be replayed over.
+* The first frame is the one the detection runs on. When either the slot count or the
+* memory limit is reached, every second frame after the first one is dropped, so the
+* replay keeps covering the whole interval with larger steps.
+**/
+struct FrameBuffer {
+	const size_t capacity;
+	const size_t maxBytes;
+	size_t decimations;
+
+	FrameBuffer(size_t capacity, size_t maxBytes);
+
+	void push(const FramePtr &frame);
+	void popFront();
+	void clear();
+
+	size_t size() const;
+	bool empty() const;
+	size_t bytes() const;
+	const FramePtr &operator[](size_t i) const;
+	const FramePtr &front() const;
+	const FramePtr &back() const;
+
+private:
+	std::vector<FramePtr> _slots;
+	std::vector<size_t> _slotBytes;
+	size_t _head;
+	size_t _count;
+	size_t _bytes;
+
+	size_t slot(size_t i) const;
+	void decimate();
+};
@@ -0,0 +1,89 @@
+#include "platform.hpp"
+#include "frame_context.hpp"
+
+const cv::Size FrameContext::flowWindow(9, 9);
+const int FrameContext::flowMaxLevel = 3;
+
+FrameContext::FrameContext(const cv::Mat &bgr, size_t id, size_t streamId)
+	: bgr(bgr), id(id), streamId(streamId), timestamp(std::chrono::high_resolution_clock::now()) {
+}
+
+const cv::Mat &FrameContext::gray() {
+	if (_gray.empty()) {
+		cv::cvtColor(bgr, _gray, cv::COLOR_BGR2GRAY);
+	}
+	return _gray;
+}
+
+const std::vector<cv::Mat> &FrameContext::pyramid() {
+	if (_pyramid.empty()) {
+		cv::buildOpticalFlowPyramid(gray(), _pyramid, flowWindow, flowMaxLevel);
+	}
+	return _pyramid;
+}
+
+std::shared_ptr<FrameContext> FrameContext::flowOnly() {
+	const std::vector<cv::Mat> &levels = pyramid();
+	auto flow = std::make_shared<FrameContext>(cv::Mat(), id, streamId);
+	flow->timestamp = timestamp;
+	flow->motion = motion;
+	// Levels are stored as image/derivatives pairs, LK recomputes the derivatives when they are missing
+	for (size_t i = 0; i < levels.size(); i += 2) {
+		flow->_pyramid.push_back(levels[i]);
+	}
+	flow->_gray = flow->_pyramid[0];
+	return flow;
+}
+
+static size_t allocatedBytes(const cv::Mat &image) {
+	if (image.empty()) return 0;
+	cv::Size whole;
+	cv::Point offset;
+	image.locateROI(whole, offset);
+	return whole.area() * image.elemSize();
+}
+
+size_t FrameContext::bytes() const {
+	size_t total = allocatedBytes(bgr);
+	for (auto &level : _pyramid) {
+		total += allocatedBytes(level);
+	}
+	// The gray image is shared with the base pyramid level in flow-only contexts
+	if (_pyramid.empty() || _gray.data != _pyramid[0].data) {
+		total += allocatedBytes(_gray);
+	}
+	return total;
+}
+
+FramePool::FramePool(size_t capacity) : _capacity(capacity) {
+}
+
+cv::Mat FramePool::acquire() {
+	std::lock_guard<std::mutex> lock(_mutex);
+	while (!_free.empty()) {
+		cv::Mat buffer = std::move(_free.back());
+		_free.pop_back();
+		// A view taken from the frame outlived it, writing into the buffer would change that view
+		if (buffer.u && buffer.u->refcount == 1) return buffer;
+	}
+	return cv::Mat();
+}
+
+FramePtr FramePool::wrap(const cv::Mat &bgr, size_t id, size_t streamId) {
+	// Frames may outlive the pool, their buffers are then simply freed
+	std::weak_ptr<FramePool> pool = shared_from_this();
+	return FramePtr(new FrameContext(bgr, id, streamId), [pool](FrameContext *frame) {
+		if (auto owner = pool.lock()) {
+			owner->release(frame->bgr);
+		}
+		delete frame;
+	});
+}
+
+void FramePool::release(cv::Mat &bgr) {
+	if (bgr.empty()) return;
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_free.size() < _capacity) {
+		_free.push_back(std::move(bgr));
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "platform.hpp"
+#include <mutex>
+#include <samples/ocv_common.hpp>
+
+/** Frame with derived images computed on first use and shared by all processing steps **/
+struct FrameContext {
+	/** LK parameters the cached pyramid is built for **/
+	static const cv::Size flowWindow;
+	static const int flowMaxLevel;
+
+	cv::Mat bgr;
+	size_t id;
+	size_t streamId;
+	/** Time the frame was captured from its source, the start of its end-to-end latency **/
+	std::chrono::high_resolution_clock::time_point timestamp;
+	/** Blocks changed since the last frame that moved, one pixel per block, empty when not gated **/
+	cv::Mat motion;
+
+	explicit FrameContext(const cv::Mat &bgr, size_t id = 0, size_t streamId = 0);
+
+	const cv::Mat &gray();
+	const std::vector<cv::Mat> &pyramid();
+
+	/** Context sharing only the pyramid images, without the color frame and the derivatives **/
+	std::shared_ptr<FrameContext> flowOnly();
+	/** Memory held by the images of this context **/
+	size_t bytes() const;
+
+private:
+	cv::Mat _gray;
+	std::vector<cv::Mat> _pyramid;
+};
+
+typedef std::shared_ptr<FrameContext> FramePtr;
+
+/**
+* Keeps the color buffers of released frames, so the next frame of the same size is decoded
+* into memory that is already allocated. Buffers come back when the last frame handle is gone.
+**/
+class FramePool : public std::enable_shared_from_this<FramePool> {
+public:
+	explicit FramePool(size_t capacity);
+
+	/** Released buffer to decode into, empty when there is none **/
+	cv::Mat acquire();
+	/** Frame handle giving its color buffer back to the pool once released **/
+	FramePtr wrap(const cv::Mat &bgr, size_t id, size_t streamId);
+
+private:
+	const size_t _capacity;
+	std::mutex _mutex;
+	std::vector<cv::Mat> _free;
+
+	void release(cv::Mat &bgr);
+};
@@ -0,0 +1,97 @@
+#include "platform.hpp"
+#include "frame_source.hpp"
+#include "raw_frames.hpp"
+
+FrameSource::~FrameSource() {}
+
+bool FrameSource::live() const {
+	return false;
+}
+
+int64_t FrameSource::timestampUs() const {
+	return -1;
+}
+
+VideoSource::VideoSource(const std::string &source) : isLive(true) {
+	bool opened = false;
+	const std::string index = source.compare(0, 3, "cam") == 0 ? source.substr(3) : std::string("-");
+	if (index.empty()) {
+		opened = cap.open(0);
+	} else if (index.find_first_not_of("0123456789") == std::string::npos) {
+		opened = cap.open(std::stoi(index));
+	} else {
+		opened = cap.open(source);
+		isLive = source.find("://") != std::string::npos;
+	}
+	if (!opened) {
+		throw std::logic_error("Cannot open input file or camera: " + source);
+	}
+	if (isLive) {
+		// Frames queued in the driver only add latency, ignored by backends that cannot change it
+		cap.set(cv::CAP_PROP_BUFFERSIZE, 1);
+	}
+}
+
+bool VideoSource::read(cv::Mat &frame) {
+	return cap.read(frame);
+}
+
+bool VideoSource::live() const {
+	return isLive;
+}
+
+SyntheticSource::SyntheticSource(cv::Size size, size_t frames)
+	: size(size), frames(frames), frameIndex(0) {
+	// Fixed seed so every run sees the same frames
+	cv::RNG rng(0x5eed);
+	background.create(size, CV_8UC3);
+	rng.fill(background, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(256));
+	cv::GaussianBlur(background, background, cv::Size(5, 5), 0);
+	texture.create(size, CV_8UC3);
+	rng.fill(texture, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(256));
+}
+
+bool SyntheticSource::read(cv::Mat &frame) {
+	if (frameIndex >= frames) return false;
+	background.copyTo(frame);
+
+	// A few discs moving on Lissajous paths give the tracker corners to follow
+	const int discs = 4;
+	const double t = static_cast<double>(frameIndex) / 30.0;
+	const int radius = std::max(8, std::min(size.width, size.height) / 12);
+	for (int i = 0; i < discs; i++) {
+		cv::Point center(
+			cvRound(size.width * (0.5 + 0.35 * std::sin(t * (0.7 + 0.3 * i) + i))),
+			cvRound(size.height * (0.5 + 0.35 * std::cos(t * (0.5 + 0.2 * i) + 2 * i))));
+		cv::Mat mask(size, CV_8UC1, cv::Scalar(0));
+		cv::circle(mask, center, radius, cv::Scalar(255), -1);
+		texture.copyTo(frame, mask);
+	}
+	frameIndex++;
+	return true;
+}
+
+std::unique_ptr<FrameSource> openFrameSource(const std::string &source) {
+	const std::string raw = "raw:", rawFast = "rawfast:";
+	if (source.compare(0, raw.size(), raw) == 0) {
+		return std::unique_ptr<FrameSource>(new RawFrameSource(source.substr(raw.size()), true));
+	}
+	if (source.compare(0, rawFast.size(), rawFast) == 0) {
+		return std::unique_ptr<FrameSource>(new RawFrameSource(source.substr(rawFast.size()), false));
+	}
+
+	const std::string synthetic = "synthetic";
+	if (source.compare(0, synthetic.size(), synthetic) != 0) {
+		return std::unique_ptr<FrameSource>(new VideoSource(source));
+	}
+
+	int width = 1280, height = 720;
+	unsigned long long frames = 300;
+	if (source.size() > synthetic.size()) {
+		if (std::sscanf(source.c_str() + synthetic.size(), ":%dx%d:%llu", &width, &height, &frames) < 2 ||
+			width <= 0 || height <= 0) {
+			throw std::logic_error("Synthetic source should be synthetic[:<width>x<height>[:<frames>]], but was " + source);
+		}
+	}
+	return std::unique_ptr<FrameSource>(new SyntheticSource(cv::Size(width, height), static_cast<size_t>(frames)));
+}
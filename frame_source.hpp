@@ -0,0 +1,52 @@
+#pragma once
+
+#include "platform.hpp"
+#include <cstdint>
+#include <samples/ocv_common.hpp>
+
+struct FrameSource {
+	virtual ~FrameSource();
+	/** Decodes the next frame, reusing the buffer of frame when it fits, returns false at the end of the source **/
+	virtual bool read(cv::Mat &frame) = 0;
+	/** Live sources produce frames at their own pace, so frames the pipeline cannot keep up with are dropped **/
+	virtual bool live() const;
+	/**
+	* Recorded capture time of the frame read last relative to the first frame, for sources replaying
+	* recordings at their pace, or -1 when frames are stamped as they are read
+	**/
+	virtual int64_t timestampUs() const;
+};
+
+/**
+* Video file, stream or camera: "cam" is the default camera, "cam<N>" selects a camera by its index.
+* Cameras and network streams ("<protocol>://...") are live sources.
+**/
+struct VideoSource : FrameSource {
+	cv::VideoCapture cap;
+	bool isLive;
+
+	explicit VideoSource(const std::string &source);
+	bool read(cv::Mat &frame) override;
+	bool live() const override;
+};
+
+/**
+* Generated frames without decoding cost: a static noise texture with textured discs
+* moving across it. Specified as "synthetic[:<width>x<height>[:<frames>]]".
+**/
+struct SyntheticSource : FrameSource {
+	const cv::Size size;
+	const size_t frames;
+	size_t frameIndex;
+	cv::Mat background;
+	cv::Mat texture;
+
+	SyntheticSource(cv::Size size, size_t frames);
+	bool read(cv::Mat &frame) override;
+};
+
+/**
+* Source of any of the kinds above, or a raw frame file replayed at its recorded pace as "raw:<path>"
+* or as fast as the pipeline takes its frames as "rawfast:<path>"
+**/
+std::unique_ptr<FrameSource> openFrameSource(const std::string &source);
@@ -0,0 +1,61 @@
+#include "platform.hpp"
+#include "head_pose_detector.hpp"
+
+using namespace InferenceEngine;
+
+HeadPoseDetector::HeadPoseDetector(const std::string &pathToModel,
+	const std::string &deviceForInference,
+	int maxBatch, bool isBatchDynamic, bool isAsync, int numRequests)
+	: FaceCropDetector("Head Pose Estimation", pathToModel, deviceForInference, maxBatch, isBatchDynamic, isAsync, numRequests),
+	outputAngleY("angle_y_fc"), outputAngleP("angle_p_fc"), outputAngleR("angle_r_fc") {
+}
+
+CNNNetwork HeadPoseDetector::read() {
+	slog::info << "Loading network files for Head Pose Estimation" << slog::endl;
+	CNNNetReader netReader;
+	/** Read network model **/
+	netReader.ReadNetwork(pathToModel);
+	/** Set the maximum batch size, dynamic batching may run less **/
+	slog::info << "Batch size is set to " << maxBatch << " for Head Pose Estimation" << slog::endl;
+	netReader.getNetwork().setBatchSize(maxBatch);
+	/** Extract model name and load its weights **/
+	std::string binFileName = fileNameNoExt(pathToModel) + ".bin";
+	netReader.ReadWeights(binFileName);
+
+	CNNNetwork network = netReader.getNetwork();
+	readInput(network);
+
+	// ---------------------------Check outputs ------------------------------------------------------------
+	slog::info << "Checking Head Pose Estimation network outputs" << slog::endl;
+	OutputsDataMap outputInfo(network.getOutputsInfo());
+	if (outputInfo.size() != 3) {
+		throw std::logic_error("Head Pose Estimation network should have 3 outputs");
+	}
+	for (const std::string &name : {outputAngleY, outputAngleP, outputAngleR}) {
+		auto it = outputInfo.find(name);
+		if (it == outputInfo.end()) {
+			throw std::logic_error("There is no " + name + " output in Head Pose Estimation network");
+		}
+		it->second->setPrecision(Precision::FP32);
+	}
+
+	slog::info << "Loading Head Pose Estimation model to the " << deviceForInference << " plugin" << slog::endl;
+	return network;
+}
+
+void HeadPoseDetector::fetchResults(int request) {
+	if (!enabled()) return;
+	InferRequest::Ptr &inferRequest = requests[request].request;
+	const float *angleY = inferRequest->GetBlob(outputAngleY)->buffer().as<float *>();
+	const float *angleP = inferRequest->GetBlob(outputAngleP)->buffer().as<float *>();
+	const float *angleR = inferRequest->GetBlob(outputAngleR)->buffer().as<float *>();
+
+	resultsFaceIds = requests[request].frameIds;
+	results.resize(resultsFaceIds.size());
+	for (size_t i = 0; i < results.size(); i++) {
+		results[i].yaw = angleY[i];
+		results[i].pitch = angleP[i];
+		results[i].roll = angleR[i];
+	}
+	releaseRequest(request);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "platform.hpp"
+#include "face_crop_detector.hpp"
+
+struct HeadPoseDetector : FaceCropDetector {
+	/** Angles in degrees **/
+	struct Result {
+		float yaw;
+		float pitch;
+		float roll;
+	};
+
+	std::string outputAngleY;
+	std::string outputAngleP;
+	std::string outputAngleR;
+	/** Results of the fetched request per batch image, with the face ids the images were enqueued with **/
+	std::vector<Result> results;
+	std::vector<size_t> resultsFaceIds;
+
+	HeadPoseDetector(const std::string &pathToModel,
+		const std::string &deviceForInference,
+		int maxBatch, bool isBatchDynamic, bool isAsync, int numRequests = 1);
+
+	InferenceEngine::CNNNetwork read() override;
+	void fetchResults(int request) override;
+};
@@ -0,0 +1,71 @@
+#include "platform.hpp"
+#include "landmarks_detector.hpp"
+
+using namespace InferenceEngine;
+
+FacialLandmarksDetector::FacialLandmarksDetector(const std::string &pathToModel,
+	const std::string &deviceForInference,
+	int maxBatch, bool isBatchDynamic, bool isAsync, int numRequests)
+	: FaceCropDetector("Facial Landmarks Estimation", pathToModel, deviceForInference, maxBatch, isBatchDynamic, isAsync, numRequests),
+	_pointsPerFace(0) {
+}
+
+CNNNetwork FacialLandmarksDetector::read() {
+	slog::info << "Loading network files for Facial Landmarks Estimation" << slog::endl;
+	CNNNetReader netReader;
+	/** Read network model **/
+	netReader.ReadNetwork(pathToModel);
+	/** Set the maximum batch size, dynamic batching may run less **/
+	slog::info << "Batch size is set to " << maxBatch << " for Facial Landmarks Estimation" << slog::endl;
+	netReader.getNetwork().setBatchSize(maxBatch);
+	/** Extract model name and load its weights **/
+	std::string binFileName = fileNameNoExt(pathToModel) + ".bin";
+	netReader.ReadWeights(binFileName);
+
+	CNNNetwork network = netReader.getNetwork();
+	readInput(network);
+
+	// ---------------------------Check outputs ------------------------------------------------------------
+	slog::info << "Checking Facial Landmarks Estimation network outputs" << slog::endl;
+	OutputsDataMap outputInfo(network.getOutputsInfo());
+	if (outputInfo.size() != 1) {
+		throw std::logic_error("Facial Landmarks Estimation network should have only one output");
+	}
+	output = outputInfo.begin()->first;
+	DataPtr &_output = outputInfo.begin()->second;
+	const SizeVector outputDims = _output->getTensorDesc().getDims();
+	// Normalized x, y pairs of every landmark, [N, 10, 1, 1] for landmarks-regression-retail-0009
+	size_t values = outputDims.size() < 2 ? 0 : 1;
+	for (size_t i = 1; i < outputDims.size(); i++) {
+		values *= outputDims[i];
+	}
+	if (!values || values % 2) {
+		throw std::logic_error("Facial Landmarks Estimation network output should hold 2 * landmarks values per face");
+	}
+	_pointsPerFace = values / 2;
+	_output->setPrecision(Precision::FP32);
+
+	slog::info << "Loading Facial Landmarks Estimation model to the " << deviceForInference << " plugin" << slog::endl;
+	return network;
+}
+
+void FacialLandmarksDetector::fetchResults(int request) {
+	if (!enabled()) return;
+	const float *normalized = requests[request].request->GetBlob(output)->buffer().as<float *>();
+	const std::vector<cv::Rect> &rects = faceRects[request];
+
+	resultsFaceIds = requests[request].frameIds;
+	results.resize(resultsFaceIds.size());
+	for (size_t i = 0; i < results.size(); i++) {
+		// Landmarks are relative to the face region the image was resized from
+		const cv::Rect &rect = rects[i];
+		const float *face = normalized + i * _pointsPerFace * 2;
+		std::vector<cv::Point2f> &points = results[i];
+		points.resize(_pointsPerFace);
+		for (size_t p = 0; p < _pointsPerFace; p++) {
+			points[p].x = rect.x + face[2 * p] * rect.width;
+			points[p].y = rect.y + face[2 * p + 1] * rect.height;
+		}
+	}
+	releaseRequest(request);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "platform.hpp"
+#include "face_crop_detector.hpp"
+
+struct FacialLandmarksDetector : FaceCropDetector {
+	std::string output;
+	/** Landmarks of the fetched request per batch image in frame coordinates, with the face ids the images were enqueued with **/
+	std::vector<std::vector<cv::Point2f>> results;
+	std::vector<size_t> resultsFaceIds;
+
+	FacialLandmarksDetector(const std::string &pathToModel,
+		const std::string &deviceForInference,
+		int maxBatch, bool isBatchDynamic, bool isAsync, int numRequests = 1);
+
+	InferenceEngine::CNNNetwork read() override;
+	void fetchResults(int request) override;
+
+private:
+	size_t _pointsPerFace;
+};
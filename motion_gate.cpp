@@ -0,0 +1,43 @@
+#include "platform.hpp"
+#include "motion_gate.hpp"
+
+MotionGate::MotionGate(double threshold) : threshold(threshold), _moved(true) {
+}
+
+const cv::Mat &MotionGate::update(const cv::Mat &bgr) {
+	const cv::Size sampleSize(sampleWidth, std::max(1, cvRound(static_cast<double>(bgr.rows) * sampleWidth / bgr.cols)));
+	const cv::Size blocks((sampleSize.width + blockSize - 1) / blockSize, (sampleSize.height + blockSize - 1) / blockSize);
+
+	// Area averaging also takes out most of the sensor noise
+	cv::resize(bgr, _small, sampleSize, 0, 0, cv::INTER_AREA);
+	cv::cvtColor(_small, _sample, cv::COLOR_BGR2GRAY);
+
+	if (_reference.empty() || _reference.size() != _sample.size()) {
+		_mask = cv::Mat(blocks, CV_8UC1, cv::Scalar(255));
+		_moved = true;
+	} else {
+		cv::absdiff(_sample, _reference, _diff);
+		cv::resize(_diff, _blockDiff, blocks, 0, 0, cv::INTER_AREA);
+		cv::threshold(_blockDiff, _mask, threshold, 255, cv::THRESH_BINARY);
+		_moved = cv::countNonZero(_mask) > 0;
+	}
+	if (_moved) {
+		std::swap(_reference, _sample);
+	}
+	return _mask;
+}
+
+bool MotionGate::moved() const {
+	return _moved;
+}
+
+cv::Mat motionMask(const cv::Mat &blocks, cv::Size frameSize, const cv::Rect &region) {
+	const int firstCol = region.x * blocks.cols / frameSize.width;
+	const int firstRow = region.y * blocks.rows / frameSize.height;
+	const int lastCol = std::min((region.x + region.width - 1) * blocks.cols / frameSize.width, blocks.cols - 1);
+	const int lastRow = std::min((region.y + region.height - 1) * blocks.rows / frameSize.height, blocks.rows - 1);
+	cv::Mat mask;
+	cv::resize(blocks(cv::Rect(firstCol, firstRow, lastCol - firstCol + 1, lastRow - firstRow + 1)), mask,
+		region.size(), 0, 0, cv::INTER_NEAREST);
+	return mask;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "platform.hpp"
+#include <samples/ocv_common.hpp>
+
+/**
+* Cheap change detector run before any per-frame work. Frames are shrunk to a small gray image and
+* compared against the last frame that moved, averaged over blocks, so slow changes add up until
+* they pass the threshold instead of being lost between consecutive frames.
+**/
+struct MotionGate {
+	/** Width of the compared images, the height keeps the frame aspect **/
+	static const int sampleWidth = 160;
+	/** Side of a block of the compared image in pixels **/
+	static const int blockSize = 8;
+
+	/** Mean absolute difference of a block in gray levels above which the block changed **/
+	const double threshold;
+
+	explicit MotionGate(double threshold);
+
+	/**
+	* Compares the frame with the reference and returns the mask of changed blocks, one pixel per
+	* block with 255 for a change. The frame becomes the reference when anything changed.
+	* Everything is changed for the first frame.
+	**/
+	const cv::Mat &update(const cv::Mat &bgr);
+	/** Whether any block changed in the last update **/
+	bool moved() const;
+
+private:
+	cv::Mat _reference;
+	cv::Mat _small;
+	cv::Mat _sample;
+	cv::Mat _diff;
+	cv::Mat _blockDiff;
+	cv::Mat _mask;
+	bool _moved;
+};
+
+/**
+* Mask of a region of the frame with the changed blocks set, to restrict searches to regions that moved.
+* Only the blocks covering the region are scaled up.
+**/
+cv::Mat motionMask(const cv::Mat &blocks, cv::Size frameSize, const cv::Rect &region);
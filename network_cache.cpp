@@ -0,0 +1,141 @@
+#include "platform.hpp"
+#include "network_cache.hpp"
+#include <cctype>
+#include <cstdint>
+#include <thread>
+#include <samples/ocv_common.hpp>
+#include <samples/slog.hpp>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+using namespace InferenceEngine;
+
+/** Bumped whenever the detectors change how they prepare a network before compiling it **/
+static const int cacheFormat = 1;
+
+static void hashBytes(uint64_t &hash, const char *data, size_t size) {
+	// 64-bit FNV-1a
+	for (size_t i = 0; i < size; i++) {
+		hash ^= static_cast<unsigned char>(data[i]);
+		hash *= 0x100000001b3ULL;
+	}
+}
+
+static void hashString(uint64_t &hash, const std::string &value) {
+	// The terminating zero keeps consecutive strings apart
+	hashBytes(hash, value.c_str(), value.size() + 1);
+}
+
+static void hashFile(uint64_t &hash, const std::string &path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		throw std::logic_error("Cannot read model file: " + path);
+	}
+	std::vector<char> buffer(1 << 20);
+	while (file) {
+		file.read(buffer.data(), buffer.size());
+		hashBytes(hash, buffer.data(), static_cast<size_t>(file.gcount()));
+	}
+}
+
+static std::string buildNumber() {
+	const Version *version = GetInferenceEngineVersion();
+	return version->buildNumber ? version->buildNumber : "";
+}
+
+NetworkCache::NetworkCache(const std::string &directory) : _directory(directory) {
+	if (_directory.empty()) return;
+	// An existing directory is fine, one that cannot be created fails the first store
+#ifdef _WIN32
+	_mkdir(_directory.c_str());
+#else
+	mkdir(_directory.c_str(), 0755);
+#endif
+}
+
+bool NetworkCache::enabled() const {
+	return !_directory.empty();
+}
+
+bool NetworkCache::exports(const std::string &device) const {
+	std::ifstream marker(noExportPath(device));
+	std::string build;
+	// A marker of another build is stale, its plugin may export
+	return !(marker && std::getline(marker, build) && build == buildNumber());
+}
+
+std::string NetworkCache::key(const std::string &pathToModel, const std::string &device, int batch,
+	const std::map<std::string, std::string> &config) const {
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	hashFile(hash, pathToModel);
+	hashFile(hash, fileNameNoExt(pathToModel) + ".bin");
+	hashString(hash, device);
+	hashString(hash, std::to_string(batch));
+	for (auto &entry : config) {
+		hashString(hash, entry.first);
+		hashString(hash, entry.second);
+	}
+	hashString(hash, buildNumber());
+	hashString(hash, std::to_string(cacheFormat));
+
+	std::ostringstream name;
+	name << fileNameNoExt(pathToModel.substr(pathToModel.find_last_of("/\\") + 1)) << '-'
+		<< std::hex << std::setw(16) << std::setfill('0') << hash;
+	return name.str();
+}
+
+bool NetworkCache::load(const std::string &key, InferencePlugin &plugin,
+	const std::map<std::string, std::string> &config, ExecutableNetwork &net) const {
+	const std::string file = path(key);
+	if (!std::ifstream(file)) return false;
+	try {
+		net = plugin.ImportNetwork(file, config);
+		return true;
+	}
+	catch (const std::exception &error) {
+		slog::warn << "Cannot import cached network " << file << ", compiling it: " << error.what() << slog::endl;
+		return false;
+	}
+}
+
+void NetworkCache::store(const std::string &key, const std::string &device, ExecutableNetwork &net) const {
+	const std::string file = path(key);
+	// Processes starting together may store the same entry, each writes its own file and renames it
+	std::ostringstream temporary;
+	temporary << file << ".tmp" << std::hex << std::hash<std::thread::id>()(std::this_thread::get_id())
+		<< std::chrono::high_resolution_clock::now().time_since_epoch().count();
+	try {
+		net.Export(temporary.str());
+	}
+	catch (const std::exception &error) {
+		std::remove(temporary.str().c_str());
+		// Later starts skip hashing the IR files for a device that cannot export
+		std::ofstream(noExportPath(device)) << buildNumber() << '\n';
+		slog::warn << "Compiled network is not cached, " << device << " cannot export it: " << error.what() << slog::endl;
+		return;
+	}
+	if (std::rename(temporary.str().c_str(), file.c_str()) != 0) {
+		// Renaming over an existing file fails on Windows
+		std::remove(file.c_str());
+		if (std::rename(temporary.str().c_str(), file.c_str()) != 0) {
+			std::remove(temporary.str().c_str());
+			slog::warn << "Cannot write cached network " << file << slog::endl;
+		}
+	}
+}
+
+std::string NetworkCache::path(const std::string &key) const {
+	return _directory + "/" + key + ".blob";
+}
+
+std::string NetworkCache::noExportPath(const std::string &device) const {
+	// Names like HETERO:FPGA,CPU are not valid file names everywhere
+	std::string name = device;
+	for (auto &c : name) {
+		if (!std::isalnum(static_cast<unsigned char>(c))) c = '_';
+	}
+	return _directory + "/" + name + ".noexport";
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "platform.hpp"
+#include <inference_engine.hpp>
+
+/**
+* On-disk cache of compiled networks, so a restart imports a network instead of compiling it again.
+* Entries are keyed by a hash of the IR files, the device, the batch size, the load config and the
+* Inference Engine build. Devices whose plugins cannot export networks compile them every time, and
+* once an export failed the cache is not even looked up for them until the Inference Engine changes.
+**/
+class NetworkCache {
+public:
+	/** Empty directory disables the cache **/
+	explicit NetworkCache(const std::string &directory);
+
+	bool enabled() const;
+	/** False once the plugin of the device failed to export a network with this Inference Engine build **/
+	bool exports(const std::string &device) const;
+	/** Name of the entry for the model compiled for the device with this batch size and config **/
+	std::string key(const std::string &pathToModel, const std::string &device, int batch,
+		const std::map<std::string, std::string> &config) const;
+	/** Imports the entry if there is one, returns false when the network has to be compiled **/
+	bool load(const std::string &key, InferenceEngine::InferencePlugin &plugin,
+		const std::map<std::string, std::string> &config, InferenceEngine::ExecutableNetwork &net) const;
+	/** Exports the compiled network, a cache that cannot be written is only reported **/
+	void store(const std::string &key, const std::string &device, InferenceEngine::ExecutableNetwork &net) const;
+
+private:
+	const std::string _directory;
+
+	std::string path(const std::string &key) const;
+	std::string noExportPath(const std::string &device) const;
+};
@@ -0,0 +1,630 @@
+#include "platform.hpp"
+#include "pipeline.hpp"
+#include "trace.hpp"
+
+/**
+* Square regions around the tracks enlarged by scale, overlapping ones merged into their bounding box.
+* Empty when the regions would cover most of the frame anyway.
+**/
+static std::vector<cv::Rect> detectionRois(const std::vector<Track> &tracks, cv::Size frameSize, double scale) {
+	const cv::Rect bounds(cv::Point(), frameSize);
+	std::vector<cv::Rect> rois;
+	for (auto &track : tracks) {
+		const cv::Rect &box = track.result.location;
+		const int side = cvRound(std::max(box.width, box.height) * scale);
+		cv::Rect roi(box.x + box.width / 2 - side / 2, box.y + box.height / 2 - side / 2, side, side);
+		roi &= bounds;
+		if (roi.area() > 0) {
+			rois.push_back(roi);
+		}
+	}
+
+	for (bool merged = true; merged; ) {
+		merged = false;
+		for (size_t i = 0; i < rois.size() && !merged; i++) {
+			for (size_t j = i + 1; j < rois.size() && !merged; j++) {
+				if ((rois[i] & rois[j]).area() <= 0) continue;
+				rois[i] = rois[i] | rois[j];
+				rois.erase(rois.begin() + j);
+				merged = true;
+			}
+		}
+	}
+
+	size_t area = 0;
+	for (auto &roi : rois) {
+		area += roi.area();
+	}
+	if (2 * area > static_cast<size_t>(bounds.area())) {
+		rois.clear();
+	}
+	return rois;
+}
+
+/**
+* Grid of tiles covering the frame, neighbours overlapping by the overlap fraction of the tile size
+* so that a face cut by one seam is whole in the other tile. Empty for a 1x1 grid.
+**/
+static std::vector<cv::Rect> frameTiles(cv::Size frameSize, cv::Size grid, double overlap) {
+	std::vector<cv::Rect> tiles;
+	if (grid.area() <= 1) return tiles;
+	const int width = cvCeil(frameSize.width / (grid.width - (grid.width - 1) * overlap));
+	const int height = cvCeil(frameSize.height / (grid.height - (grid.height - 1) * overlap));
+	for (int row = 0; row < grid.height; row++) {
+		for (int col = 0; col < grid.width; col++) {
+			// The last row and column are aligned with the frame border
+			const int x = col + 1 < grid.width ? cvRound(col * width * (1.0 - overlap)) : frameSize.width - width;
+			const int y = row + 1 < grid.height ? cvRound(row * height * (1.0 - overlap)) : frameSize.height - height;
+			tiles.push_back(cv::Rect(x, y, width, height) & cv::Rect(cv::Point(), frameSize));
+		}
+	}
+	return tiles;
+}
+
+Pipeline::Stream::Stream(size_t id, const std::string &sourceName, const PipelineConfig &config, size_t numRequests)
+	: id(id), source(openFrameSource(sourceName)), live(source->live()),
+	// Enough buffers for every frame that can be queued between the stages at once
+	framePool(std::make_shared<FramePool>(2 * config.queueCapacity + numRequests + 2)), decoded(config.queueCapacity), detectionRequests(numRequests), detectionResults(numRequests),
+	tracked(config.queueCapacity), analyzed(config.queueCapacity), decodedFrames(0), decodeMs(0.0),
+	scheduler(config.minDetectionInterval, config.maxDetectionInterval, config.driftTolerance, config.fullScanInterval),
+	pending(config.catchupFrames, config.catchupBytes),
+	catchUp(config.catchupMs, config.catchupFrames, config.catchupBytes), gate(config.motionThreshold),
+	detectionInFlight(false), escalationDue(false), lastDetectionEscalated(false), trackingFinished(false), requestsFinished(false), analyticsFinished(false), outputFinished(false) {
+	tracker.refillRatio = static_cast<float>(config.keypointRefill);
+}
+
+Pipeline::Pipeline(const std::vector<std::string> &sources, FaceDetector &detector, FaceDetector &escalation,
+	HeadPoseDetector &headPose, FacialLandmarksDetector &landmarks, const PipelineConfig &config)
+	: _detector(detector), _escalation(escalation), _headPose(headPose), _landmarks(landmarks), _config(config), _nextOutput(0),
+	_detections(0), _escalations(0), _stop(false) {
+	for (size_t i = 0; i < sources.size(); i++) {
+		_streams.emplace_back(new Stream(i, sources[i], config, detector.numRequests));
+	}
+}
+
+Pipeline::~Pipeline() {
+	stop();
+	for (auto &thread : _threads) {
+		thread.join();
+	}
+}
+
+void Pipeline::start() {
+	size_t workers = _config.workers;
+	if (!workers) {
+		workers = std::min<size_t>(_streams.size(), std::max(std::thread::hardware_concurrency(), 1u));
+	}
+	workers = std::min(workers, _streams.size());
+
+	for (auto &stream : _streams) {
+		Stream *s = stream.get();
+		_threads.emplace_back(&Pipeline::run, this, [this, s] { decode(*s); });
+	}
+	_threads.emplace_back(&Pipeline::run, this, [this] { detect(); });
+	if (analyticsEnabled()) {
+		_threads.emplace_back(&Pipeline::run, this, [this] { analyze(); });
+	}
+	for (size_t worker = 0; worker < workers; worker++) {
+		_threads.emplace_back(&Pipeline::run, this, [this, worker, workers] { work(worker, workers); });
+	}
+}
+
+void Pipeline::run(const std::function<void()> &stage) {
+	try {
+		stage();
+	}
+	catch (...) {
+		std::lock_guard<std::mutex> lock(_errorMutex);
+		if (!_error) {
+			_error = std::current_exception();
+		}
+		stop();
+	}
+}
+
+bool Pipeline::pop(TrackedFrame &tracked) {
+	bool timedOut = false;
+	while (!pop(tracked, std::chrono::milliseconds(1000), timedOut)) {
+		if (!timedOut) return false;
+	}
+	return true;
+}
+
+bool Pipeline::pop(TrackedFrame &tracked, std::chrono::milliseconds timeout, bool &timedOut) {
+	timedOut = false;
+	const auto deadline = std::chrono::high_resolution_clock::now() + timeout;
+	// Streams are served round-robin so a fast one cannot starve the others
+	for (int attempt = 0; !_stop; attempt++) {
+		bool running = false;
+		for (size_t i = 0; i < _streams.size(); i++) {
+			Stream &stream = *_streams[(_nextOutput + i) % _streams.size()];
+			if (stream.outputFinished) continue;
+			running = true;
+			SpscQueue<TrackedFrame> &output = analyticsEnabled() ? stream.analyzed : stream.tracked;
+			if (!output.tryPop(tracked)) continue;
+			if (!tracked.frame) {
+				stream.outputFinished = true;
+				continue;
+			}
+			_nextOutput = (stream.id + 1) % _streams.size();
+			Instrumentation::record(Stage::EndToEnd, std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::high_resolution_clock::now() - tracked.frame->timestamp));
+			Trace::frameSpan("end_to_end", tracked.frame->timestamp, tracked.frame->id, tracked.frame->streamId);
+			return true;
+		}
+		if (!running) return false;
+		if (std::chrono::high_resolution_clock::now() >= deadline) {
+			timedOut = true;
+			return false;
+		}
+		backoff(attempt);
+	}
+	return false;
+}
+
+void Pipeline::stop() {
+	_stop = true;
+}
+
+void Pipeline::join() {
+	for (auto &thread : _threads) {
+		thread.join();
+	}
+	_threads.clear();
+	if (_error) {
+		std::rethrow_exception(_error);
+	}
+}
+
+bool Pipeline::analyticsEnabled() const {
+	return _headPose.enabled() || _landmarks.enabled();
+}
+
+size_t Pipeline::streams() const {
+	return _streams.size();
+}
+
+size_t Pipeline::decodedFrames() const {
+	size_t frames = 0;
+	for (auto &stream : _streams) {
+		frames += stream->decodedFrames;
+	}
+	return frames;
+}
+
+size_t Pipeline::detections() const {
+	return _detections;
+}
+
+size_t Pipeline::escalations() const {
+	return _escalations;
+}
+
+size_t Pipeline::droppedFrames() const {
+	size_t frames = 0;
+	for (auto &stream : _streams) {
+		frames += stream->latest.dropped();
+	}
+	return frames;
+}
+
+void Pipeline::decode(Stream &stream) {
+	Trace::nameThread("decode #" + std::to_string(stream.id));
+	Recorder &recorder = Instrumentation::local();
+	Stopwatch watch;
+	size_t id = 0;
+	// Capture time of the first frame of a replayed recording, recorded timestamps are relative to it
+	std::chrono::high_resolution_clock::time_point replayStart;
+	while (!_stop) {
+		// Decodes into the buffer of a frame no longer referenced downstream when there is one
+		cv::Mat decoded = stream.framePool->acquire();
+		watch.start();
+		bool frameReadStatus = stream.source->read(decoded);
+		recorder.record(Stage::Decode, watch.elapsed());
+		if (!frameReadStatus) break;
+		Trace::span("decode", watch.startTime(), id, stream.id);
+		stream.decodeMs = recorder.smoothedMs(Stage::Decode);
+
+		auto captured = std::chrono::high_resolution_clock::now();
+		const int64_t recordedUs = stream.source->timestampUs();
+		if (recordedUs >= 0) {
+			// Recordings are handed over at their recorded pace and keep their recorded capture times
+			if (!id) {
+				replayStart = captured - std::chrono::microseconds(recordedUs);
+			}
+			captured = replayStart + std::chrono::microseconds(recordedUs);
+			std::this_thread::sleep_until(captured);
+		}
+
+		FramePtr frame = stream.framePool->wrap(decoded, id++, stream.id);
+		frame->timestamp = captured;
+		stream.decodedFrames++;
+		if (stream.live) {
+			// Capture never waits for tracking, a frame not taken yet is replaced by the newer one
+			stream.latest.put(frame);
+		} else if (!stream.decoded.push(frame, _stop)) {
+			return;
+		}
+	}
+	// Empty handle marks the end of the stream
+	if (stream.live) {
+		stream.latest.put(FramePtr());
+	} else {
+		stream.decoded.push(FramePtr(), _stop);
+	}
+}
+
+void Pipeline::detect() {
+	Trace::nameThread("detect");
+
+	// Frames stay referenced until the requests of all their regions complete, keyed by the request tag
+	struct InFlight {
+		FramePtr frame;
+		Stopwatch enqueued;
+		size_t regions;
+		size_t remaining;
+		bool escalated;
+		std::vector<FaceDetector::Result> results;
+	};
+	// Each detector batches its own regions, waiting for room in a batch
+	struct Lane {
+		FaceDetector *detector;
+		std::deque<std::pair<size_t, cv::Rect>> regions;
+		std::chrono::high_resolution_clock::time_point batchStart;
+	};
+	std::map<size_t, InFlight> inFlight;
+	std::vector<Lane> lanes(1);
+	lanes[0].detector = &_detector;
+	if (_escalation.enabled()) {
+		lanes.push_back(Lane());
+		lanes[1].detector = &_escalation;
+	}
+	size_t nextTag = 0;
+	size_t nextStream = 0;
+	size_t finishedStreams = 0;
+	int idle = 0;
+	const std::chrono::duration<double, std::milli> batchWait(_config.batchWaitMs);
+
+	auto hasRoom = [](const Lane &lane) {
+		return lane.detector->enquedFrames < lane.detector->maxBatch &&
+			(lane.detector->enquedFrames || lane.detector->idleRequests());
+	};
+	auto waiting = [&lanes]() {
+		for (auto &lane : lanes) {
+			if (!lane.regions.empty()) return true;
+		}
+		return false;
+	};
+	auto fill = [&](Lane &lane) {
+		while (!lane.regions.empty() && hasRoom(lane)) {
+			if (!lane.detector->enquedFrames) {
+				lane.batchStart = std::chrono::high_resolution_clock::now();
+			}
+			const size_t tag = lane.regions.front().first;
+			const FramePtr &frame = inFlight[tag].frame;
+			Stopwatch enqueue;
+			lane.detector->enqueue(frame->bgr, lane.regions.front().second, tag);
+			Trace::span("enqueue", enqueue.startTime(), frame->id, frame->streamId);
+			lane.regions.pop_front();
+		}
+	};
+
+	while (!_stop && !(finishedStreams == _streams.size() && inFlight.empty())) {
+		// Frames of different streams requested at about the same time share one batched request,
+		// regions of one frame may span several requests
+		for (auto &lane : lanes) {
+			fill(lane);
+		}
+		for (size_t i = 0; i < _streams.size() && !waiting(); i++) {
+			if (std::none_of(lanes.begin(), lanes.end(), hasRoom)) break;
+			Stream &stream = *_streams[(nextStream + i) % _streams.size()];
+			DetectionRequest request;
+			if (stream.requestsFinished || !stream.detectionRequests.tryPop(request)) continue;
+			if (!request.frame) {
+				stream.requestsFinished = true;
+				finishedStreams++;
+				continue;
+			}
+			if (request.rois.empty()) {
+				request.rois.push_back(cv::Rect(cv::Point(), request.frame->bgr.size()));
+			}
+			Lane &lane = lanes[request.escalate && lanes.size() > 1 ? 1 : 0];
+			InFlight &entry = inFlight[nextTag];
+			entry.frame = request.frame;
+			entry.regions = entry.remaining = request.rois.size();
+			entry.escalated = lane.detector == &_escalation;
+			for (auto &roi : request.rois) {
+				lane.regions.emplace_back(nextTag, roi);
+			}
+			nextTag++;
+			nextStream = (stream.id + 1) % _streams.size();
+			fill(lane);
+		}
+		for (auto &lane : lanes) {
+			FaceDetector &detector = *lane.detector;
+			if (detector.enquedFrames && (detector.enquedFrames == detector.maxBatch || !lane.regions.empty() ||
+				finishedStreams == _streams.size() ||
+				std::chrono::high_resolution_clock::now() - lane.batchStart >= batchWait)) {
+				detector.submitRequest();
+			}
+		}
+
+		// A single detector blocks on its requests, two are polled in turn
+		bool completed = false;
+		for (auto &lane : lanes) {
+			FaceDetector &detector = *lane.detector;
+			int request = detector.waitCompleted(std::chrono::milliseconds(lanes.size() > 1 ? 0 : 1));
+			if (request < 0) continue;
+			completed = true;
+			Stopwatch fetch;
+			detector.fetchResults(request);
+
+			// Results are demultiplexed back to the streams the batch images came from
+			for (size_t image = 0; image < detector.results.size(); image++) {
+				auto it = inFlight.find(detector.resultsFrameIds[image]);
+				InFlight &entry = it->second;
+				const std::vector<FaceDetector::Result> &results = detector.results[image];
+				entry.results.insert(entry.results.end(), results.begin(), results.end());
+				if (!image) {
+					// One span per request, tagged with its first image
+					Trace::span("fetch", fetch.startTime(), entry.frame->id, entry.frame->streamId);
+				}
+				if (--entry.remaining) continue;
+
+				DetectionResult detection;
+				detection.frame = entry.frame;
+				detection.results = std::move(entry.results);
+				detection.escalated = entry.escalated;
+				if (entry.regions > 1) {
+					// A face on a tile seam or cut by the borders of adjacent regions is found in both of them
+					suppressOverlaps(detection.results, 0.6f);
+				}
+				Trace::frameSpan(entry.escalated ? "inference_escalated" : "inference", entry.enqueued.startTime(),
+					detection.frame->id, detection.frame->streamId);
+				inFlight.erase(it);
+				_detections++;
+				if (detection.escalated) {
+					_escalations++;
+				}
+				Stream &stream = *_streams[detection.frame->streamId];
+				if (!stream.detectionResults.push(std::move(detection), _stop)) return;
+			}
+		}
+		if (lanes.size() > 1) {
+			idle = completed ? 0 : idle + 1;
+			backoff(idle);
+		}
+	}
+}
+
+/** Face region of a tracked frame, results are stored back by its index **/
+struct FaceRef {
+	const cv::Mat *frame;
+	cv::Rect rect;
+	size_t frameIndex;
+	size_t trackIndex;
+};
+
+/** Runs the network on all faces, filling requests of up to maxBatch faces of any frames **/
+template <typename Detector, typename Store>
+static void runOnFaces(Detector &detector, const std::vector<FaceRef> &faces, const std::atomic<bool> &stop, Store store) {
+	if (!detector.enabled()) return;
+	size_t next = 0;
+	size_t done = 0;
+	while (done < faces.size() && !stop) {
+		// Keep every idle request of the pool busy
+		while (next < faces.size() && (detector.enquedFaces || detector.idleRequests())) {
+			detector.enqueue(*faces[next].frame, faces[next].rect, next);
+			next++;
+			if (detector.enquedFaces == detector.maxBatch || next == faces.size()) {
+				detector.submitRequest();
+			}
+		}
+		int request = detector.waitCompleted(std::chrono::milliseconds(1));
+		if (request < 0) continue;
+		detector.fetchResults(request);
+		for (size_t i = 0; i < detector.results.size(); i++) {
+			store(faces[detector.resultsFaceIds[i]], detector.results[i]);
+		}
+		done += detector.results.size();
+	}
+}
+
+void Pipeline::analyze() {
+	Trace::nameThread("analytics");
+	Recorder &recorder = Instrumentation::local();
+	std::vector<TrackedFrame> frames;
+	std::vector<FaceRef> faces;
+	std::vector<Stream *> ended;
+	size_t finishedStreams = 0;
+
+	for (int attempt = 0; !_stop && finishedStreams < _streams.size(); ) {
+		// Faces of every frame waiting on any stream go through the networks together
+		frames.clear();
+		ended.clear();
+		for (auto &stream : _streams) {
+			if (stream->analyticsFinished) continue;
+			TrackedFrame tracked;
+			while (stream->tracked.tryPop(tracked)) {
+				if (!tracked.frame) {
+					stream->analyticsFinished = true;
+					ended.push_back(stream.get());
+					finishedStreams++;
+					break;
+				}
+				frames.push_back(std::move(tracked));
+			}
+		}
+		if (frames.empty() && ended.empty()) {
+			backoff(++attempt);
+			continue;
+		}
+		attempt = 0;
+
+		Stopwatch watch;
+		faces.clear();
+		for (size_t f = 0; f < frames.size(); f++) {
+			TrackedFrame &frame = frames[f];
+			const cv::Rect bounds(cv::Point(), frame.frame->bgr.size());
+			frame.headPoses.assign(_headPose.enabled() ? frame.tracks.size() : 0, HeadPoseDetector::Result());
+			frame.landmarks.assign(_landmarks.enabled() ? frame.tracks.size() : 0, std::vector<cv::Point2f>());
+			for (size_t t = 0; t < frame.tracks.size(); t++) {
+				// Tracks drifting out of the frame have nothing to analyze
+				const cv::Rect &location = frame.tracks[t].result.location;
+				if ((location & bounds).area() <= 0) continue;
+				FaceRef face = {&frame.frame->bgr, location, f, t};
+				faces.push_back(face);
+			}
+		}
+		runOnFaces(_headPose, faces, _stop, [&frames](const FaceRef &face, const HeadPoseDetector::Result &pose) {
+			frames[face.frameIndex].headPoses[face.trackIndex] = pose;
+		});
+		runOnFaces(_landmarks, faces, _stop, [&frames](const FaceRef &face, const std::vector<cv::Point2f> &points) {
+			frames[face.frameIndex].landmarks[face.trackIndex] = points;
+		});
+		if (!frames.empty()) {
+			recorder.record(Stage::Analytics, watch.elapsed());
+			Trace::span("analytics", watch.startTime(), frames.front().frame->id, frames.front().frame->streamId);
+		}
+
+		for (auto &frame : frames) {
+			Stream &stream = *_streams[frame.frame->streamId];
+			if (!stream.analyzed.push(std::move(frame), _stop)) return;
+		}
+		for (auto stream : ended) {
+			stream->analyzed.push(TrackedFrame(), _stop);
+		}
+	}
+}
+
+void Pipeline::work(size_t worker, size_t workers) {
+	Trace::nameThread("tracker #" + std::to_string(worker));
+	for (int attempt = 0; !_stop; ) {
+		bool running = false;
+		bool tracked = false;
+		for (size_t i = worker; i < _streams.size(); i += workers) {
+			Stream &stream = *_streams[i];
+			if (stream.trackingFinished) continue;
+			running = true;
+			tracked = track(stream) || tracked;
+		}
+		if (!running) return;
+		attempt = tracked ? 0 : attempt + 1;
+		backoff(attempt);
+	}
+}
+
+bool Pipeline::track(Stream &stream) {
+	FramePtr frame;
+	if (!(stream.live ? stream.latest.tryTake(frame) : stream.decoded.tryPop(frame))) return false;
+	if (!frame) {
+		stream.trackingFinished = true;
+		stream.detectionRequests.push(DetectionRequest(), _stop);
+		stream.tracked.push(TrackedFrame(), _stop);
+		return true;
+	}
+
+	Recorder &recorder = Instrumentation::local();
+	Tracker &tracker = stream.tracker;
+	Stopwatch watch;
+
+	// Nothing is tracked, replayed or detected on a frame that did not move, the tracks stay where
+	// they are and the next frame that moves is tracked from the last one that did
+	bool moved = true;
+	if (_config.motionThreshold > 0) {
+		frame->motion = stream.gate.update(frame->bgr).clone();
+		moved = stream.gate.moved();
+	}
+
+	// Track live faces, each box follows its own keypoints
+	if (moved && stream.prevFrame) {
+		tracker.track(*stream.prevFrame, *frame);
+		stream.scheduler.update(tracker.health);
+	}
+
+	FramePtr flow_frame;
+	if (moved) {
+		flow_frame = frame->flowOnly();
+		if (stream.detectionInFlight) {
+			stream.pending.push(flow_frame);
+		}
+	}
+
+	// Replay detected faces from the frame they were detected on up to the current one,
+	// a few frames at a time
+	DetectionResult detection;
+	if (stream.detectionResults.tryPop(detection)) {
+		recorder.record(Stage::Detection, stream.detectionWatch.elapsed());
+		Trace::frameSpan("detection", stream.detectionWatch.startTime(), detection.frame->id, stream.id);
+		stream.detectionInFlight = false;
+		stream.lastDetectionEscalated = detection.escalated;
+		// A routine detection finding a face it is unsure about has the next one escalated
+		stream.escalationDue = false;
+		for (auto &result : detection.results) {
+			if (!detection.escalated && result.confidence < _config.escalationConfidence) {
+				stream.escalationDue = true;
+			}
+		}
+		stream.catchUp.start(tracker.makeCandidates(detection.results, *stream.pending.front()), stream.pending);
+		// The replay holds the frames now, keeping them here too would double the memory of a stream
+		stream.pending.clear();
+	} else if (moved) {
+		stream.catchUp.push(flow_frame);
+	}
+	if (stream.catchUp.active()) {
+		Stopwatch replay;
+		if (stream.catchUp.step(tracker)) {
+			tracker.merge(stream.catchUp.candidates);
+			stream.catchUp.finish();
+			// A track the routine detection did not find again also escalates the next detection
+			for (auto &track : tracker.tracks) {
+				if (!stream.lastDetectionEscalated && track.missedDetections > 0) {
+					stream.escalationDue = true;
+				}
+			}
+		}
+		Trace::span("catch_up", replay.startTime(), frame->id, stream.id);
+	}
+
+	if (moved && !stream.detectionInFlight && stream.scheduler.shouldDetect()) {
+		DetectionRequest request;
+		request.frame = frame;
+		const bool periodicScan = stream.scheduler.fullScanDue();
+		// Periodic scans and detections after lost, missed or uncertain faces go to the escalation detector
+		request.escalate = _escalation.enabled() && (periodicScan || stream.escalationDue || stream.scheduler.tracksLost);
+		// Known faces are re-anchored on regions around them, new ones are found by periodic full scans
+		if (_config.roiScale > 0 && !periodicScan) {
+			request.rois = detectionRois(tracker.tracks, frame->bgr.size(), _config.roiScale);
+			if (request.rois.size() > _config.maxRois) {
+				request.rois.clear();
+			}
+		}
+		const bool fullScan = request.rois.empty();
+		if (fullScan) {
+			request.rois = frameTiles(frame->bgr.size(), _config.tileGrid, _config.tileOverlap);
+		}
+		if (stream.detectionRequests.tryPush(request)) {
+			stream.detectionWatch.start();
+			stream.detectionInFlight = true;
+			// Without regions every detection scans the full frame, only the periodic ones restart the count
+			stream.scheduler.detectionSubmitted(_config.roiScale > 0 ? fullScan : periodicScan);
+			stream.pending.clear();
+			stream.pending.push(flow_frame);
+		}
+	}
+	recorder.record(Stage::Tracker, watch.elapsed());
+	Trace::span("tracker", watch.startTime(), frame->id, stream.id);
+
+	TrackedFrame tracked;
+	tracked.frame = frame;
+	tracked.tracks = tracker.tracks;
+	tracked.decodeMs = stream.decodeMs;
+	tracked.trackerMs = recorder.smoothedMs(Stage::Tracker);
+	if (moved) {
+		stream.prevFrame = frame;
+	}
+
+	// Output is the one blocking push of a worker, it throttles tracking to the display rate
+	stream.tracked.push(std::move(tracked), _stop);
+	return true;
+}
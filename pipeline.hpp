@@ -0,0 +1,172 @@
+#pragma once
+
+#include "platform.hpp"
+#include <deque>
+#include <mutex>
+#include "utils.h"
+#include "catch_up.hpp"
+#include "detection_scheduler.hpp"
+#include "face_detector.hpp"
+#include "frame_buffer.hpp"
+#include "frame_context.hpp"
+#include "frame_source.hpp"
+#include "head_pose_detector.hpp"
+#include "landmarks_detector.hpp"
+#include "motion_gate.hpp"
+#include "spsc_queue.hpp"
+#include "tracker.hpp"
+
+struct PipelineConfig {
+	int minDetectionInterval;
+	int maxDetectionInterval;
+	double driftTolerance;
+	size_t catchupFrames;
+	size_t catchupBytes;
+	double catchupMs;
+	size_t queueCapacity;
+	/** Longest time a partially filled detection batch waits for more frames **/
+	double batchWaitMs;
+	/** Tracking threads shared by all streams, 0 to use one per stream up to the hardware threads **/
+	size_t workers;
+	/** Size of the regions around tracks re-detected between full scans relative to the face, 0 to always scan full frames **/
+	double roiScale;
+	/** Most regions of one re-detection, more tracks than that get a full scan **/
+	size_t maxRois;
+	/** Every fullScanInterval-th detection of a stream scans the whole frame **/
+	int fullScanInterval;
+	/** Columns and rows of the overlapping tiles a full scan is split into, 1x1 for a single image **/
+	cv::Size tileGrid;
+	double tileOverlap;
+	/** Mean gray level change of a block for a frame to count as moved, 0 to process every frame **/
+	double motionThreshold;
+	/** With an escalation detector, a detection with a face below this confidence escalates the next one **/
+	double escalationConfidence;
+	/** Share of the keypoints per face below which a track gets new ones between detections, 0 to never refill **/
+	double keypointRefill;
+};
+
+/** Frame with the state of its tracks, handed from the tracking stage to the output **/
+struct TrackedFrame {
+	FramePtr frame;
+	std::vector<Track> tracks;
+	/** Per track results of the face analytics networks, empty when a network is disabled **/
+	std::vector<HeadPoseDetector::Result> headPoses;
+	std::vector<std::vector<cv::Point2f>> landmarks;
+	double decodeMs;
+	double trackerMs;
+};
+
+/**
+* Runs decoding, face detection and tracking of several video sources on dedicated threads.
+* Every source is decoded on its own thread and keeps its own tracking state, while all of
+* them share one detector and a pool of tracking workers. Enabled face analytics networks run on
+* the tracked faces of all streams on one more thread. Stages pass frame handles through
+* bounded single-producer/single-consumer queues and block when the next stage falls behind,
+* so throughput is limited by the slowest stage. Live sources are the exception: their capture
+* never waits, tracking always takes the newest frame and older ones are dropped.
+* When an escalation detector is enabled, the detector runs routine re-detections and the
+* escalation detector, usually a larger model, runs periodic full scans and re-detections after
+* tracks were lost, missed or found with low confidence.
+**/
+class Pipeline {
+public:
+	Pipeline(const std::vector<std::string> &sources, FaceDetector &detector, FaceDetector &escalation,
+		HeadPoseDetector &headPose, FacialLandmarksDetector &landmarks, const PipelineConfig &config);
+	~Pipeline();
+
+	void start();
+	/** Waits for the next tracked frame of any stream, returns false after the last one **/
+	bool pop(TrackedFrame &tracked);
+	/** Same, but returns false with timedOut set when no frame arrived within the timeout **/
+	bool pop(TrackedFrame &tracked, std::chrono::milliseconds timeout, bool &timedOut);
+	void stop();
+	/** Waits for all stages and rethrows the first exception thrown by any of them **/
+	void join();
+
+	size_t streams() const;
+	size_t decodedFrames() const;
+	/** Frames of live sources replaced by a newer one before tracking took them **/
+	size_t droppedFrames() const;
+	/** Completed detections, and those of them run by the escalation detector **/
+	size_t detections() const;
+	size_t escalations() const;
+
+private:
+	/** Frame to run face detection on, only in the regions when there are any **/
+	struct DetectionRequest {
+		FramePtr frame;
+		std::vector<cv::Rect> rois;
+		bool escalate;
+	};
+
+	struct DetectionResult {
+		FramePtr frame;
+		std::vector<FaceDetector::Result> results;
+		bool escalated;
+	};
+
+	struct Stream {
+		const size_t id;
+		std::unique_ptr<FrameSource> source;
+		const bool live;
+		std::shared_ptr<FramePool> framePool;
+
+		/** Live sources hand over only their newest frame, others every frame in order **/
+		SpscQueue<FramePtr> decoded;
+		LatestValue<FramePtr> latest;
+		SpscQueue<DetectionRequest> detectionRequests;
+		SpscQueue<DetectionResult> detectionResults;
+		SpscQueue<TrackedFrame> tracked;
+		SpscQueue<TrackedFrame> analyzed;
+		std::atomic<size_t> decodedFrames;
+		std::atomic<double> decodeMs;
+
+		// Tracking state, touched only by the worker the stream is assigned to
+		Tracker tracker;
+		DetectionScheduler scheduler;
+		/** Frames the detection in flight is replayed over, starting with the frame it runs on **/
+		FrameBuffer pending;
+		CatchUp catchUp;
+		MotionGate gate;
+		/** Runs from the detection request to its results reaching the tracker **/
+		Stopwatch detectionWatch;
+		FramePtr prevFrame;
+		bool detectionInFlight;
+		/** The last routine detection missed a track or found a face with low confidence **/
+		bool escalationDue;
+		bool lastDetectionEscalated;
+		bool trackingFinished;
+
+		// Owned by the detection, the analytics and the output threads respectively
+		bool requestsFinished;
+		bool analyticsFinished;
+		bool outputFinished;
+
+		Stream(size_t id, const std::string &sourceName, const PipelineConfig &config, size_t numRequests);
+	};
+
+	FaceDetector &_detector;
+	FaceDetector &_escalation;
+	HeadPoseDetector &_headPose;
+	FacialLandmarksDetector &_landmarks;
+	const PipelineConfig _config;
+	std::vector<std::unique_ptr<Stream>> _streams;
+	size_t _nextOutput;
+
+	std::atomic<size_t> _detections;
+	std::atomic<size_t> _escalations;
+
+	std::atomic<bool> _stop;
+	std::vector<std::thread> _threads;
+	std::mutex _errorMutex;
+	std::exception_ptr _error;
+
+	void run(const std::function<void()> &stage);
+	void decode(Stream &stream);
+	void detect();
+	void work(size_t worker, size_t workers);
+	void analyze();
+	bool analyticsEnabled() const;
+	/** Tracks the next decoded frame of the stream, returns false if there was none **/
+	bool track(Stream &stream);
+};
@@ -3,12 +3,18 @@
 #include <functional>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <random>
 #include <memory>
 #include <chrono>
+#include <cmath>
 #include <vector>
 #include <string>
 #include <utility>
 #include <algorithm>
 #include <iterator>
+#include <limits>
 #include <map>
+#include <numeric>
+#include <iomanip>
+#include <cstdio>
@@ -0,0 +1,190 @@
+#include "platform.hpp"
+#include "raw_frames.hpp"
+#include <cstring>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static uint64_t alignUp(uint64_t bytes) {
+	return (bytes + RawFrames::alignment - 1) / RawFrames::alignment * RawFrames::alignment;
+}
+
+RawFrameWriter::RawFrameWriter(const std::string &path) : _file(path, std::ios::binary), _offset(0) {
+	if (!_file) {
+		throw std::logic_error("Cannot create raw frame file: " + path);
+	}
+	std::memset(&_header, 0, sizeof(_header));
+	_header.magic = RawFrames::magic;
+	_header.version = RawFrames::version;
+	// The header is written again with the frame count and the index offset by close()
+	pad(RawFrames::alignment);
+}
+
+RawFrameWriter::~RawFrameWriter() {
+	try {
+		close();
+	}
+	catch (...) {
+	}
+}
+
+void RawFrameWriter::write(const cv::Mat &frame, int64_t timestampUs) {
+	if (!_file.is_open()) {
+		throw std::logic_error("Raw frame file is already closed");
+	}
+	if (_index.empty()) {
+		_header.width = frame.cols;
+		_header.height = frame.rows;
+		_header.type = frame.type();
+		_header.step = static_cast<uint32_t>(frame.cols * frame.elemSize());
+	} else if (static_cast<uint32_t>(frame.cols) != _header.width || static_cast<uint32_t>(frame.rows) != _header.height ||
+		static_cast<uint32_t>(frame.type()) != _header.type) {
+		throw std::logic_error("All frames of a raw frame file should have the size and type of the first one");
+	}
+
+	_index.push_back({_offset, timestampUs});
+	for (int row = 0; row < frame.rows; row++) {
+		_file.write(reinterpret_cast<const char *>(frame.ptr(row)), _header.step);
+	}
+	_offset += static_cast<uint64_t>(_header.step) * _header.height;
+	pad(alignUp(_offset) - _offset);
+	if (!_file) {
+		throw std::logic_error("Cannot write raw frame " + std::to_string(_index.size() - 1));
+	}
+}
+
+void RawFrameWriter::close() {
+	if (!_file.is_open()) return;
+	_header.frames = _index.size();
+	_header.indexOffset = _offset;
+	_file.write(reinterpret_cast<const char *>(_index.data()), _index.size() * sizeof(RawFrameIndex));
+	_file.seekp(0);
+	_file.write(reinterpret_cast<const char *>(&_header), sizeof(_header));
+	const bool written = static_cast<bool>(_file);
+	_file.close();
+	if (!written) {
+		throw std::logic_error("Cannot write the raw frame index");
+	}
+}
+
+size_t RawFrameWriter::frames() const {
+	return _index.size();
+}
+
+void RawFrameWriter::pad(uint64_t bytes) {
+	static const char zeros[RawFrames::alignment] = {};
+	_offset += bytes;
+	while (bytes) {
+		const size_t chunk = static_cast<size_t>(std::min<uint64_t>(bytes, sizeof(zeros)));
+		_file.write(zeros, chunk);
+		bytes -= chunk;
+	}
+}
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string &path) : _data(nullptr), _size(0), _file(INVALID_HANDLE_VALUE), _mapping(nullptr) {
+	_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	LARGE_INTEGER size;
+	if (_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(_file, &size)) {
+		if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+		throw std::logic_error("Cannot open file: " + path);
+	}
+	_size = static_cast<size_t>(size.QuadPart);
+	_mapping = _size ? CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+	_data = _mapping ? static_cast<const char *>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+	if (!_data) {
+		if (_mapping) CloseHandle(_mapping);
+		CloseHandle(_file);
+		throw std::logic_error("Cannot map file: " + path);
+	}
+}
+
+MappedFile::~MappedFile() {
+	UnmapViewOfFile(_data);
+	CloseHandle(_mapping);
+	CloseHandle(_file);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &path) : _data(nullptr), _size(0), _file(nullptr), _mapping(nullptr) {
+	const int fd = open(path.c_str(), O_RDONLY);
+	struct stat status;
+	if (fd < 0 || fstat(fd, &status) != 0) {
+		const int error = errno;
+		if (fd >= 0) ::close(fd);
+		throw std::logic_error("Cannot open file " + path + ": " + std::strerror(error));
+	}
+	_size = static_cast<size_t>(status.st_size);
+	int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+	// Replays should not measure page faults reading the file
+	flags |= MAP_POPULATE;
+#endif
+	void *memory = _size ? mmap(nullptr, _size, PROT_READ, flags, fd, 0) : MAP_FAILED;
+	const int error = errno;
+	::close(fd);
+	if (memory == MAP_FAILED) {
+		throw std::logic_error("Cannot map file " + path + ": " + std::strerror(error));
+	}
+	_data = static_cast<const char *>(memory);
+}
+
+MappedFile::~MappedFile() {
+	munmap(const_cast<char *>(_data), _size);
+}
+
+#endif
+
+const char *MappedFile::data() const {
+	return _data;
+}
+
+size_t MappedFile::size() const {
+	return _size;
+}
+
+RawFrameSource::RawFrameSource(const std::string &path, bool paced)
+	: file(path), header(nullptr), index(nullptr), frameIndex(0), paced(paced) {
+	header = reinterpret_cast<const RawFramesHeader *>(file.data());
+	if (file.size() < sizeof(RawFramesHeader) || header->magic != RawFrames::magic) {
+		throw std::logic_error("Not a raw frame file: " + path);
+	}
+	if (header->version != RawFrames::version) {
+		throw std::logic_error("Unsupported raw frame file version " + std::to_string(header->version) + ": " + path);
+	}
+	const uint64_t frameBytes = static_cast<uint64_t>(header->step) * header->height;
+	if (header->indexOffset > file.size() || header->frames > (file.size() - header->indexOffset) / sizeof(RawFrameIndex) ||
+		header->step < header->width * CV_ELEM_SIZE(header->type)) {
+		throw std::logic_error("Raw frame file is truncated or damaged: " + path);
+	}
+	index = reinterpret_cast<const RawFrameIndex *>(file.data() + header->indexOffset);
+	for (size_t i = 0; i < header->frames; i++) {
+		if (index[i].offset % RawFrames::alignment || index[i].offset > header->indexOffset ||
+			frameBytes > header->indexOffset - index[i].offset) {
+			throw std::logic_error("Raw frame file is truncated or damaged: " + path);
+		}
+	}
+}
+
+bool RawFrameSource::read(cv::Mat &frame) {
+	if (frameIndex >= header->frames) return false;
+	// Views of the read-only mapping, the pipeline never writes into its input frames
+	char *pixels = const_cast<char *>(file.data() + index[frameIndex].offset);
+	frame = cv::Mat(header->height, header->width, header->type, pixels, header->step);
+	frameIndex++;
+	return true;
+}
+
+int64_t RawFrameSource::timestampUs() const {
+	if (!paced || !frameIndex) return -1;
+	return index[frameIndex - 1].timestampUs;
+}
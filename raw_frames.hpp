@@ -0,0 +1,97 @@
+#pragma once
+
+#include "platform.hpp"
+#include <cstdint>
+#include <samples/ocv_common.hpp>
+#include "frame_source.hpp"
+
+/**
+* Raw frame dataset: a header, page-aligned frames stored as they are in memory, and an index of
+* the frames at the end of the file. Replaying it maps the file, so frames cost no decoding.
+**/
+struct RawFramesHeader {
+	/** "RAWF" **/
+	uint32_t magic;
+	uint32_t version;
+	uint32_t width;
+	uint32_t height;
+	/** OpenCV type of every frame, CV_8UC3 for BGR **/
+	uint32_t type;
+	/** Bytes of one row, rows follow each other without gaps **/
+	uint32_t step;
+	uint64_t frames;
+	/** Offset of frames RawFrameIndex entries, one per frame **/
+	uint64_t indexOffset;
+	char padding[24];
+};
+
+struct RawFrameIndex {
+	/** Offset of the first pixel, a multiple of RawFrames::alignment **/
+	uint64_t offset;
+	/** Capture time relative to the first frame **/
+	int64_t timestampUs;
+};
+
+static_assert(sizeof(RawFramesHeader) == 64 && sizeof(RawFrameIndex) == 16, "Raw frame layout is stored in files");
+
+struct RawFrames {
+	static const uint32_t magic = 0x46574152;
+	static const uint32_t version = 1;
+	/** Page size frames are aligned to, so every frame starts on its own page of the mapping **/
+	static const size_t alignment = 4096;
+};
+
+/** Appends frames of one size and type to a raw frame dataset, the index is written by close() **/
+class RawFrameWriter {
+public:
+	explicit RawFrameWriter(const std::string &path);
+	~RawFrameWriter();
+
+	void write(const cv::Mat &frame, int64_t timestampUs);
+	void close();
+	size_t frames() const;
+
+private:
+	std::ofstream _file;
+	RawFramesHeader _header;
+	std::vector<RawFrameIndex> _index;
+	uint64_t _offset;
+
+	void pad(uint64_t bytes);
+};
+
+/** Read-only mapping of a whole file **/
+class MappedFile {
+public:
+	explicit MappedFile(const std::string &path);
+	~MappedFile();
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	const char *data() const;
+	size_t size() const;
+
+private:
+	const char *_data;
+	size_t _size;
+	void *_file;
+	void *_mapping;
+};
+
+/**
+* Replays a raw frame dataset written by cam_stream_record, specified as "raw:<path>". Frames are
+* views of the mapping without a copy: they are read-only and valid while the source exists.
+* A paced source reports the recorded timestamps, so the pipeline hands frames over at the recorded
+* pace and measures latencies from the recorded capture times.
+**/
+struct RawFrameSource : FrameSource {
+	MappedFile file;
+	const RawFramesHeader *header;
+	const RawFrameIndex *index;
+	size_t frameIndex;
+	const bool paced;
+
+	RawFrameSource(const std::string &path, bool paced);
+	bool read(cv::Mat &frame) override;
+	int64_t timestampUs() const override;
+};
@@ -0,0 +1,83 @@
+#include "platform.hpp"
+#include <csignal>
+#include <gflags/gflags.h>
+#include <samples/ocv_common.hpp>
+#include <samples/slog.hpp>
+
+#include "utils.h"
+#include "record.hpp"
+#include "frame_source.hpp"
+#include "raw_frames.hpp"
+
+static volatile std::sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+    // The loop stops after the current frame, so the index is still written
+    stopRequested = 1;
+}
+
+bool ParseAndCheckCommandLine(int argc, char *argv[]) {
+    gflags::ParseCommandLineNonHelpFlags(&argc, &argv, true);
+    if (FLAGS_h) {
+        showRecordUsage();
+        return false;
+    }
+    slog::info << "Parsing input parameters" << slog::endl;
+
+    if (FLAGS_i.empty()) {
+        throw std::logic_error("Parameter -i is not set");
+    }
+
+    if (FLAGS_o.empty()) {
+        throw std::logic_error("Parameter -o is not set");
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        if (!ParseAndCheckCommandLine(argc, argv)) {
+            return 0;
+        }
+
+        slog::info << "Reading input" << slog::endl;
+        std::unique_ptr<FrameSource> source = openFrameSource(FLAGS_i);
+        RawFrameWriter writer(FLAGS_o);
+
+        std::signal(SIGINT, onSignal);
+        std::signal(SIGTERM, onSignal);
+
+        // Timestamps are taken when each frame has been read, relative to the first one, recordings keep theirs
+        Stopwatch total;
+        Stopwatch capture;
+        cv::Mat frame;
+        while (!stopRequested && (!FLAGS_frames || writer.frames() < FLAGS_frames)) {
+            if (!source->read(frame)) break;
+            if (!writer.frames()) {
+                capture.start();
+            }
+            const int64_t recordedUs = source->timestampUs();
+            const int64_t timestampUs = recordedUs >= 0 ? recordedUs :
+                std::chrono::duration_cast<std::chrono::microseconds>(capture.elapsed()).count();
+            writer.write(frame, timestampUs);
+        }
+        writer.close();
+
+        const double totalMs = total.elapsedMs();
+        slog::info << "Number of recorded frames: " << writer.frames() << slog::endl;
+        slog::info << "Recording throughput: " << writer.frames() * (1000.0 / totalMs) << " fps" << slog::endl;
+        slog::info << "Frames written to " << FLAGS_o << slog::endl;
+    }
+    catch (const std::exception& error) {
+        slog::err << error.what() << slog::endl;
+        return 1;
+    }
+    catch (...) {
+        slog::err << "Unknown/internal exception happened." << slog::endl;
+        return 1;
+    }
+
+    slog::info << "Execution successful" << slog::endl;
+    return 0;
+}
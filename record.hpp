@@ -0,0 +1,48 @@
+#pragma once
+
+#include "platform.hpp"
+#include <gflags/gflags.h>
+
+/// @brief Message for help argument
+static const char help_message[] = "Print a usage message";
+
+/// @brief Message for the recorded source
+static const char video_message[] = "Optional. Video file, camera (\"cam\" or \"cam<index>\"), generated frames " \
+"(\"synthetic[:<width>x<height>[:<frames>]]\") or another raw frame file (\"raw:<path>\") to record. " \
+"Default value is \"cam\" to work with camera.";
+
+/// @brief Message for the raw frame file path
+static const char output_message[] = "Optional. Path to the raw frame file the frames are written to (default is frames.raw).";
+
+/// @brief Message for the number of recorded frames
+static const char frames_message[] = "Optional. Number of frames to record, 0 records until the source ends or Ctrl+C (default is 0).";
+
+/// \brief Define flag for showing help message <br>
+DEFINE_bool(h, false, help_message);
+
+/// \brief Define parameter for the recorded source <br>
+/// It is an optional parameter
+DEFINE_string(i, "cam", video_message);
+
+/// \brief Define parameter for the raw frame file path <br>
+/// It is an optional parameter
+DEFINE_string(o, "frames.raw", output_message);
+
+/// \brief Define parameter for the number of recorded frames <br>
+/// It is an optional parameter
+DEFINE_uint32(frames, 0, frames_message);
+
+/**
+* \brief This function shows a help message
+*/
+
+static void showRecordUsage() {
+    std::cout << std::endl;
+    std::cout << "cam_stream_record [OPTION]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << std::endl;
+    std::cout << "    -h                         " << help_message << std::endl;
+    std::cout << "    -i \"<path>\"                " << video_message << std::endl;
+    std::cout << "    -o \"<path>\"                " << output_message << std::endl;
+    std::cout << "    -frames \"<num>\"            " << frames_message << std::endl;
+}
@@ -0,0 +1,143 @@
+#include "platform.hpp"
+#include "renderer.hpp"
+#include "trace.hpp"
+
+Renderer::Renderer(size_t streams, const std::vector<std::string> &labels, double maxFps)
+	: _labels(labels), _period(1.0 / std::max(maxFps, 0.1)), _canvases(streams),
+	_closing(false), _keyPressed(false), _waitForKey(false) {
+	for (size_t i = 0; i < streams; i++) {
+		_latest.emplace_back(new LatestValue<TrackedFrame>());
+	}
+#ifndef CAM_STREAM_HEADLESS
+	_thread = std::thread(&Renderer::run, this);
+#endif
+}
+
+Renderer::~Renderer() {
+	close(false);
+}
+
+void Renderer::submit(TrackedFrame tracked) {
+#ifndef CAM_STREAM_HEADLESS
+	const size_t stream = tracked.frame->streamId;
+	_latest[stream]->put(std::move(tracked));
+#endif
+}
+
+bool Renderer::keyPressed() const {
+	return _keyPressed;
+}
+
+void Renderer::close(bool waitForKey) {
+	if (!_thread.joinable()) return;
+	_waitForKey = waitForKey;
+	_closing = true;
+	_thread.join();
+}
+
+size_t Renderer::skippedFrames() const {
+	size_t frames = 0;
+	for (auto &latest : _latest) {
+		frames += latest->dropped();
+	}
+	return frames;
+}
+
+#ifndef CAM_STREAM_HEADLESS
+
+void Renderer::run() {
+	Trace::nameThread("renderer");
+	Recorder &recorder = Instrumentation::local();
+	bool shown = false;
+	for (bool closing = false; !closing; ) {
+		// Frames submitted before closing are still shown
+		closing = _closing;
+		const auto deadline = std::chrono::high_resolution_clock::now() + _period;
+		for (size_t stream = 0; stream < _latest.size(); stream++) {
+			TrackedFrame tracked;
+			if (!_latest[stream]->tryTake(tracked)) continue;
+			Stopwatch visualization;
+			draw(tracked, _canvases[stream]);
+
+			std::string window = "Detection results";
+			if (_latest.size() > 1) {
+				window += " #" + std::to_string(stream);
+			}
+			cv::imshow(window, _canvases[stream]);
+			shown = true;
+			recorder.record(Stage::Visualization, visualization.elapsed());
+			Trace::span("visualization", visualization.startTime(), tracked.frame->id, tracked.frame->streamId);
+		}
+
+		// Waiting for a key runs the window events for the rest of the display period
+		const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+			deadline - std::chrono::high_resolution_clock::now());
+		if (!shown) {
+			std::this_thread::sleep_for(remaining);
+		} else if (cv::waitKey(std::max(1, static_cast<int>(remaining.count()))) != -1) {
+			_keyPressed = true;
+		}
+	}
+	if (shown) {
+		if (_waitForKey) {
+			cv::waitKey(0);
+		}
+		cv::destroyAllWindows();
+	}
+}
+
+void Renderer::draw(const TrackedFrame &tracked, cv::Mat &canvas) const {
+	// The canvas keeps its buffer while the frame size does not change
+	tracked.frame->bgr.copyTo(canvas);
+	char text[128];
+
+	std::snprintf(text, sizeof(text), "OpenCV cap/render time: %.2f ms",
+		tracked.decodeMs + Instrumentation::local().smoothedMs(Stage::Visualization));
+	cv::putText(canvas, text, cv::Point2f(0, 25), cv::FONT_HERSHEY_TRIPLEX, 0.5, cv::Scalar(0, 255, 0));
+
+	std::snprintf(text, sizeof(text), "Keypoint detection time: %.2f ms (%.2f fps)",
+		tracked.trackerMs, 1000.0 / tracked.trackerMs);
+	cv::putText(canvas, text, cv::Point2f(0, 45), cv::FONT_HERSHEY_TRIPLEX, 0.5, cv::Scalar(0, 255, 0));
+
+	// For every tracked face
+	for (size_t i = 0; i < tracked.tracks.size(); i++) {
+		const Track &track = tracked.tracks[i];
+		const FaceDetector::Result &result = track.result;
+
+		if (result.label >= 0 && static_cast<size_t>(result.label) < _labels.size()) {
+			std::snprintf(text, sizeof(text), "#%d %s: %.3f", track.id, _labels[result.label].c_str(), result.confidence);
+		} else {
+			std::snprintf(text, sizeof(text), "#%d label #%d: %.3f", track.id, result.label, result.confidence);
+		}
+		cv::putText(canvas, text, cv::Point2f(result.location.x, result.location.y - 15),
+			cv::FONT_HERSHEY_COMPLEX_SMALL, 0.8, cv::Scalar(0, 0, 255));
+
+		cv::rectangle(canvas, result.location, cv::Scalar(100, 100, 100), 1);
+
+		// For every feature point of the face
+		for (auto &point : track.points) {
+			cv::circle(canvas, point, 2, cv::Scalar(255, 255, 0), -1);
+		}
+
+		if (!tracked.headPoses.empty()) {
+			const HeadPoseDetector::Result &pose = tracked.headPoses[i];
+			std::snprintf(text, sizeof(text), "y %.0f p %.0f r %.0f", pose.yaw, pose.pitch, pose.roll);
+			cv::putText(canvas, text, cv::Point2f(result.location.x, result.location.y + result.location.height + 15),
+				cv::FONT_HERSHEY_COMPLEX_SMALL, 0.8, cv::Scalar(0, 0, 255));
+		}
+
+		if (!tracked.landmarks.empty()) {
+			for (auto &point : tracked.landmarks[i]) {
+				cv::circle(canvas, point, 2, cv::Scalar(0, 255, 255), -1);
+			}
+		}
+	}
+}
+
+#else
+
+void Renderer::run() {}
+
+void Renderer::draw(const TrackedFrame &, cv::Mat &) const {}
+
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "platform.hpp"
+#include <atomic>
+#include <thread>
+#include "pipeline.hpp"
+#include "spsc_queue.hpp"
+
+/**
+* Draws the tracks of the latest output frame of every stream and shows them on its own thread, at
+* most maxFps times a second whatever the processing rate. The output loop only hands over frames,
+* frames arriving faster than they are shown are skipped. Windows exist only in builds with a
+* display, in headless builds (CAM_STREAM_HEADLESS) nothing is drawn and no thread is started.
+**/
+class Renderer {
+public:
+	Renderer(size_t streams, const std::vector<std::string> &labels, double maxFps);
+	~Renderer();
+
+	/** Replaces the frame waiting to be shown for the stream of this one **/
+	void submit(TrackedFrame tracked);
+	/** Whether a key was pressed in any window **/
+	bool keyPressed() const;
+	/** Shows the frames still waiting, then waits for a key press if requested and closes the windows **/
+	void close(bool waitForKey);
+	/** Frames replaced by a newer one before they were shown **/
+	size_t skippedFrames() const;
+
+private:
+	const std::vector<std::string> _labels;
+	const std::chrono::duration<double> _period;
+	std::vector<std::unique_ptr<LatestValue<TrackedFrame>>> _latest;
+	/** Canvas per stream, drawn on again for every frame of the stream **/
+	std::vector<cv::Mat> _canvases;
+	std::atomic<bool> _closing;
+	std::atomic<bool> _keyPressed;
+	bool _waitForKey;
+	std::thread _thread;
+
+	void run();
+	void draw(const TrackedFrame &tracked, cv::Mat &canvas) const;
+};
@@ -0,0 +1,208 @@
+#include "platform.hpp"
+#include "result_sink.hpp"
+#include <cstring>
+#include <new>
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+ResultSink::ResultSink()
+	: _epochOffset(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch() -
+		std::chrono::high_resolution_clock::now().time_since_epoch())) {
+}
+
+ResultSink::~ResultSink() {}
+
+const std::vector<TrackRecord> &ResultSink::records(const TrackedFrame &tracked) {
+	TrackRecord record;
+	std::memset(&record, 0, sizeof(record));
+	record.frameId = tracked.frame->id;
+	record.timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(
+		tracked.frame->timestamp.time_since_epoch() + _epochOffset).count();
+	record.streamId = static_cast<uint32_t>(tracked.frame->streamId);
+	record.trackId = -1;
+	record.trackCount = static_cast<uint16_t>(std::min<size_t>(tracked.tracks.size(), 0xffff));
+
+	_records.clear();
+	if (tracked.tracks.empty()) {
+		_records.push_back(record);
+	}
+	for (size_t i = 0; i < record.trackCount; i++) {
+		const Track &track = tracked.tracks[i];
+		record.trackId = track.id;
+		record.x = track.result.location.x;
+		record.y = track.result.location.y;
+		record.width = track.result.location.width;
+		record.height = track.result.location.height;
+		record.confidence = track.result.confidence;
+		record.trackIndex = static_cast<uint16_t>(i);
+		_records.push_back(record);
+	}
+	return _records;
+}
+
+#ifdef _WIN32
+
+ResultRing::ResultRing(const std::string &name, size_t capacity)
+	: _name(name), _capacity(capacity), _bytes(0), _memory(nullptr), _header(nullptr), _slots(nullptr) {
+	throw std::logic_error("Shared memory result ring is supported on POSIX systems only");
+}
+
+ResultRing::~ResultRing() {}
+
+void ResultRing::write(const TrackedFrame &) {}
+
+ResultSocket::ResultSocket(const std::string &path) : _path(path), _socket(-1), _dropped(0) {
+	throw std::logic_error("Unix socket result output is supported on POSIX systems only");
+}
+
+ResultSocket::~ResultSocket() {}
+
+void ResultSocket::write(const TrackedFrame &) {}
+
+#else
+
+ResultRing::ResultRing(const std::string &name, size_t capacity)
+	: _name("/" + name), _capacity(capacity), _bytes(sizeof(Header) + capacity * sizeof(Slot)),
+	_memory(MAP_FAILED), _header(nullptr), _slots(nullptr) {
+	if (name.empty() || name.find('/') != std::string::npos || !capacity) {
+		throw std::logic_error("Result ring should be shm:<name>[:<records>] with a name without '/' and at least 1 record");
+	}
+	const int fd = shm_open(_name.c_str(), O_CREAT | O_RDWR, 0644);
+	if (fd < 0) {
+		throw std::logic_error("Cannot create shared memory " + _name + ": " + std::strerror(errno));
+	}
+	if (ftruncate(fd, static_cast<off_t>(_bytes)) == 0) {
+		_memory = mmap(nullptr, _bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	const int error = errno;
+	close(fd);
+	if (_memory == MAP_FAILED) {
+		shm_unlink(_name.c_str());
+		throw std::logic_error("Cannot map shared memory " + _name + ": " + std::strerror(error));
+	}
+
+	// A region left by an earlier run is reset, readers check the magic before anything else
+	_header = new (_memory) Header;
+	_header->magic.store(0, std::memory_order_relaxed);
+	_slots = reinterpret_cast<Slot *>(static_cast<char *>(_memory) + sizeof(Header));
+	for (size_t i = 0; i < capacity; i++) {
+		new (&_slots[i]) Slot;
+		_slots[i].sequence.store(0, std::memory_order_relaxed);
+	}
+	_header->version = ringVersion;
+	_header->slotSize = sizeof(Slot);
+	_header->capacity = static_cast<uint32_t>(capacity);
+	_header->written.store(0, std::memory_order_relaxed);
+	_header->magic.store(ringMagic, std::memory_order_release);
+}
+
+ResultRing::~ResultRing() {
+	// Readers that mapped the ring keep it until they unmap it
+	munmap(_memory, _bytes);
+	shm_unlink(_name.c_str());
+}
+
+void ResultRing::write(const TrackedFrame &tracked) {
+	uint64_t index = _header->written.load(std::memory_order_relaxed);
+	for (auto &record : records(tracked)) {
+		Slot &slot = _slots[index % _capacity];
+		slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.record = record;
+		slot.sequence.store(2 * (index + 1), std::memory_order_release);
+		index++;
+	}
+	_header->written.store(index, std::memory_order_release);
+}
+
+ResultSocket::ResultSocket(const std::string &path) : _path(path), _socket(-1), _dropped(0) {
+	sockaddr_un address;
+	if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+		throw std::logic_error("Result socket path should be 1 to " + std::to_string(sizeof(address.sun_path) - 1) +
+			" characters, but was " + path);
+	}
+	_socket = socket(AF_UNIX, SOCK_DGRAM, 0);
+	if (_socket < 0) {
+		throw std::logic_error(std::string("Cannot create result socket: ") + std::strerror(errno));
+	}
+}
+
+ResultSocket::~ResultSocket() {
+	close(_socket);
+}
+
+void ResultSocket::write(const TrackedFrame &tracked) {
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	std::strncpy(address.sun_path, _path.c_str(), sizeof(address.sun_path) - 1);
+
+	const std::vector<TrackRecord> &frameRecords = records(tracked);
+	const ssize_t bytes = static_cast<ssize_t>(frameRecords.size() * sizeof(TrackRecord));
+	if (sendto(_socket, frameRecords.data(), bytes, MSG_DONTWAIT,
+		reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != bytes) {
+		_dropped++;
+	}
+}
+
+#endif
+
+size_t ResultSocket::dropped() const {
+	return _dropped;
+}
+
+ResultJsonLines::ResultJsonLines(const std::string &path) : _out(&std::cout) {
+	_line << std::fixed << std::setprecision(3);
+	if (path != "-") {
+		_file.open(path);
+		if (!_file) {
+			throw std::logic_error("Cannot open result file: " + path);
+		}
+		_out = &_file;
+	}
+}
+
+void ResultJsonLines::write(const TrackedFrame &tracked) {
+	const std::vector<TrackRecord> &frameRecords = records(tracked);
+	std::ostringstream &out = _line;
+	out.str("");
+	out << "{\"stream\": " << frameRecords[0].streamId << ", \"frame\": " << frameRecords[0].frameId
+		<< ", \"timestamp_us\": " << frameRecords[0].timestampUs << ", \"tracks\": [";
+	for (size_t i = 0; i < frameRecords[0].trackCount; i++) {
+		const TrackRecord &record = frameRecords[i];
+		out << (i ? ", " : "") << "{\"id\": " << record.trackId << ", \"x\": " << record.x << ", \"y\": " << record.y
+			<< ", \"width\": " << record.width << ", \"height\": " << record.height
+			<< ", \"confidence\": " << record.confidence << "}";
+	}
+	out << "]}\n";
+	*_out << out.str();
+}
+
+std::unique_ptr<ResultSink> openResultSink(const std::string &spec) {
+	const std::string ringPrefix = "shm:", socketPrefix = "unix:";
+	if (spec.compare(0, ringPrefix.size(), ringPrefix) == 0) {
+		std::string name = spec.substr(ringPrefix.size());
+		size_t capacity = 4096;
+		const size_t separator = name.find(':');
+		if (separator != std::string::npos) {
+			const std::string records = name.substr(separator + 1);
+			if (records.empty() || records.find_first_not_of("0123456789") != std::string::npos) {
+				throw std::logic_error("Result ring should be shm:<name>[:<records>], but was " + spec);
+			}
+			capacity = std::stoul(records);
+			name.resize(separator);
+		}
+		return std::unique_ptr<ResultSink>(new ResultRing(name, capacity));
+	}
+	if (spec.compare(0, socketPrefix.size(), socketPrefix) == 0) {
+		return std::unique_ptr<ResultSink>(new ResultSocket(spec.substr(socketPrefix.size())));
+	}
+	return std::unique_ptr<ResultSink>(new ResultJsonLines(spec));
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "platform.hpp"
+#include <atomic>
+#include <cstdint>
+#include "pipeline.hpp"
+
+/**
+* Fixed-layout record of one track of one frame, the same in every binary sink. A frame without
+* tracks is published as a single record with trackId -1 and trackCount 0, so consumers see
+* every frame.
+**/
+struct TrackRecord {
+	uint64_t frameId;
+	/** Capture time in microseconds since the Unix epoch **/
+	int64_t timestampUs;
+	uint32_t streamId;
+	int32_t trackId;
+	int32_t x;
+	int32_t y;
+	int32_t width;
+	int32_t height;
+	float confidence;
+	uint16_t trackIndex;
+	uint16_t trackCount;
+};
+
+static_assert(sizeof(TrackRecord) == 48, "TrackRecord layout is shared with consumers");
+
+/** Publishes the tracks of every output frame to consumers outside the process **/
+class ResultSink {
+public:
+	virtual ~ResultSink();
+	virtual void write(const TrackedFrame &tracked) = 0;
+
+protected:
+	ResultSink();
+	/** Records of the frame, reusing the buffer of the previous frame **/
+	const std::vector<TrackRecord> &records(const TrackedFrame &tracked);
+
+private:
+	std::vector<TrackRecord> _records;
+	/** Frame timestamps are taken from a clock that need not count from the Unix epoch **/
+	std::chrono::nanoseconds _epochOffset;
+};
+
+/**
+* Ring of records in POSIX shared memory "/<name>" that readers map themselves, so records
+* are never copied on their way to consumers. The writer never waits: the newest records
+* overwrite the oldest ones. The region starts with a ResultRing::Header followed by
+* capacity slots; record n is in slot n % capacity, and its slot sequence is odd while it is
+* written and 2 * (n + 1) once complete. A reader copies the record and accepts it if the
+* sequence is 2 * (n + 1) both before and after the copy.
+**/
+class ResultRing : public ResultSink {
+public:
+	struct Header {
+		/** ringMagic once the ring is initialized **/
+		std::atomic<uint32_t> magic;
+		uint32_t version;
+		uint32_t slotSize;
+		uint32_t capacity;
+		/** Number of records published so far **/
+		std::atomic<uint64_t> written;
+		char padding[40];
+	};
+
+	struct Slot {
+		std::atomic<uint64_t> sequence;
+		TrackRecord record;
+	};
+
+	/** "TRKR" **/
+	static const uint32_t ringMagic = 0x524b5254;
+	static const uint32_t ringVersion = 1;
+
+	ResultRing(const std::string &name, size_t capacity);
+	~ResultRing();
+	void write(const TrackedFrame &tracked) override;
+
+private:
+	const std::string _name;
+	const size_t _capacity;
+	size_t _bytes;
+	void *_memory;
+	Header *_header;
+	Slot *_slots;
+};
+
+/**
+* Sends the records of every frame as one datagram to the Unix domain socket a consumer bound
+* at path. Frames are dropped instead of waiting when there is no consumer or it falls behind.
+**/
+class ResultSocket : public ResultSink {
+public:
+	explicit ResultSocket(const std::string &path);
+	~ResultSocket();
+	void write(const TrackedFrame &tracked) override;
+
+	size_t dropped() const;
+
+private:
+	const std::string _path;
+	int _socket;
+	size_t _dropped;
+};
+
+/** One JSON object per frame and line, for consumers that cannot read the binary records **/
+class ResultJsonLines : public ResultSink {
+public:
+	/** "-" writes to the standard output **/
+	explicit ResultJsonLines(const std::string &path);
+	void write(const TrackedFrame &tracked) override;
+
+private:
+	std::ofstream _file;
+	std::ostream *_out;
+	std::ostringstream _line;
+};
+
+/** "shm:<name>[:<records>]", "unix:<path>" or the path of a JSON-lines file **/
+std::unique_ptr<ResultSink> openResultSink(const std::string &spec);
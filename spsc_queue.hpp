@@ -0,0 +1,124 @@
+#pragma once
+
+#include "platform.hpp"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+/** Waits a little longer with every failed attempt: spins, then yields, then sleeps **/
+inline void backoff(int attempt) {
+	if (attempt < 64) return;
+	if (attempt < 128) {
+		std::this_thread::yield();
+	} else {
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+}
+
+/**
+* Bounded lock-free queue for exactly one producer thread and one consumer thread.
+* Blocking push and pop back off from spinning to sleeping and give up once stop is set.
+**/
+template <typename T>
+class SpscQueue {
+public:
+	explicit SpscQueue(size_t capacity) : _slots(capacity + 1), _head(0), _tail(0) {
+	}
+
+	bool tryPush(T &value) {
+		const size_t tail = _tail.load(std::memory_order_relaxed);
+		const size_t next = increment(tail);
+		if (next == _head.load(std::memory_order_acquire)) {
+			return false;
+		}
+		_slots[tail] = std::move(value);
+		_tail.store(next, std::memory_order_release);
+		return true;
+	}
+
+	bool tryPop(T &value) {
+		const size_t head = _head.load(std::memory_order_relaxed);
+		if (head == _tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		value = std::move(_slots[head]);
+		_slots[head] = T();
+		_head.store(increment(head), std::memory_order_release);
+		return true;
+	}
+
+	bool push(T value, const std::atomic<bool> &stop) {
+		for (int attempt = 0; !tryPush(value); attempt++) {
+			if (stop.load(std::memory_order_relaxed)) return false;
+			backoff(attempt);
+		}
+		return true;
+	}
+
+	bool pop(T &value, const std::atomic<bool> &stop) {
+		for (int attempt = 0; !tryPop(value); attempt++) {
+			if (stop.load(std::memory_order_relaxed)) return false;
+			backoff(attempt);
+		}
+		return true;
+	}
+
+	size_t capacity() const {
+		return _slots.size() - 1;
+	}
+
+private:
+	std::vector<T> _slots;
+	// Producer and consumer indices live on separate cache lines
+	std::atomic<size_t> _head;
+	char _padding[64];
+	std::atomic<size_t> _tail;
+
+	size_t increment(size_t index) const {
+		return index + 1 == _slots.size() ? 0 : index + 1;
+	}
+};
+
+/**
+* Single slot where a new value replaces the one not taken yet, for consumers that only need
+* the latest value. Replaced values are counted as dropped.
+**/
+template <typename T>
+class LatestValue {
+public:
+	LatestValue() : _full(false), _dropped(0) {
+	}
+
+	void put(T value) {
+		// The replaced value is destroyed after the lock is released
+		T replaced;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (_full) {
+				replaced = std::move(_value);
+				_dropped++;
+			}
+			_value = std::move(value);
+			_full = true;
+		}
+	}
+
+	bool tryTake(T &value) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (!_full) return false;
+		value = std::move(_value);
+		_value = T();
+		_full = false;
+		return true;
+	}
+
+	size_t dropped() const {
+		return _dropped;
+	}
+
+private:
+	std::mutex _mutex;
+	T _value;
+	bool _full;
+	std::atomic<size_t> _dropped;
+};
@@ -0,0 +1,105 @@
+#include "platform.hpp"
+#include "ssd_decoder.hpp"
+#include <opencv2/core/hal/intrin.hpp>
+
+size_t DetectionBuffer::size() const {
+	return conf.size();
+}
+
+void DetectionBuffer::clear() {
+	resize(0);
+}
+
+void DetectionBuffer::resize(size_t count) {
+	x.resize(count);
+	y.resize(count);
+	w.resize(count);
+	h.resize(count);
+	conf.resize(count);
+	label.resize(count);
+	image_id.resize(count);
+}
+
+SsdDecoder::SsdDecoder(float threshold, float enlarge) : threshold(threshold), enlarge(enlarge) {
+}
+
+size_t SsdDecoder::decode(const float *detections, int maxProposalCount,
+	const std::vector<cv::Size> &imageSizes, DetectionBuffer &out) {
+	// Sized for the worst case once, shrinking keeps the capacity for the next requests
+	out.resize(maxProposalCount);
+	_scaleX.resize(maxProposalCount);
+	_scaleY.resize(maxProposalCount);
+
+	size_t count = select(detections, maxProposalCount, imageSizes, out);
+	transform(out, count);
+	out.resize(count);
+	return count;
+}
+
+void SsdDecoder::append(const float *proposal, const std::vector<cv::Size> &imageSizes,
+	DetectionBuffer &out, size_t &count) {
+	const int image = static_cast<int>(proposal[0]);
+	if (image >= static_cast<int>(imageSizes.size())) return;
+
+	// Corners are kept normalized here, transform scales them to the image
+	out.x[count] = proposal[3];
+	out.y[count] = proposal[4];
+	out.w[count] = proposal[5];
+	out.h[count] = proposal[6];
+	out.conf[count] = proposal[2];
+	out.label[count] = static_cast<int>(proposal[1]);
+	out.image_id[count] = image;
+	_scaleX[count] = static_cast<float>(imageSizes[image].width);
+	_scaleY[count] = static_cast<float>(imageSizes[image].height);
+	count++;
+}
+
+size_t SsdDecoder::select(const float *detections, int maxProposalCount,
+	const std::vector<cv::Size> &imageSizes, DetectionBuffer &out) {
+	size_t count = 0;
+	// Proposals are interleaved with a stride of objectSize floats, so the scan stays scalar: building
+	// vectors from the strided image id and confidence columns costs as much as comparing them one by one
+	for (int i = 0; i < maxProposalCount; i++) {
+		const float *p = detections + i * objectSize;
+		if (p[0] < 0) break;
+		if (p[2] > threshold) {
+			append(p, imageSizes, out, count);
+		}
+	}
+	return count;
+}
+
+void SsdDecoder::transform(DetectionBuffer &out, size_t count) const {
+	size_t i = 0;
+#if CV_SIMD128
+	const cv::v_float32x4 half = cv::v_setall_f32(0.5f);
+	const cv::v_float32x4 enlargement = cv::v_setall_f32(enlarge);
+	for (; i + 4 <= count; i += 4) {
+		cv::v_float32x4 sx = cv::v_load(&_scaleX[i]);
+		cv::v_float32x4 sy = cv::v_load(&_scaleY[i]);
+		cv::v_float32x4 x0 = cv::v_load(&out.x[i]) * sx;
+		cv::v_float32x4 y0 = cv::v_load(&out.y[i]) * sy;
+		cv::v_float32x4 bw = cv::v_load(&out.w[i]) * sx - x0;
+		cv::v_float32x4 bh = cv::v_load(&out.h[i]) * sy - y0;
+
+		cv::v_float32x4 side = cv::v_max(bw, bh) * enlargement;
+		cv::v_float32x4 shift = side * half;
+		cv::v_store(&out.x[i], x0 + bw * half - shift);
+		cv::v_store(&out.y[i], y0 + bh * half - shift);
+		cv::v_store(&out.w[i], side);
+		cv::v_store(&out.h[i], side);
+	}
+#endif
+	for (; i < count; i++) {
+		float x0 = out.x[i] * _scaleX[i];
+		float y0 = out.y[i] * _scaleY[i];
+		float bw = out.w[i] * _scaleX[i] - x0;
+		float bh = out.h[i] * _scaleY[i] - y0;
+
+		float side = std::max(bw, bh) * enlarge;
+		out.x[i] = x0 + bw / 2 - side / 2;
+		out.y[i] = y0 + bh / 2 - side / 2;
+		out.w[i] = side;
+		out.h[i] = side;
+	}
+}
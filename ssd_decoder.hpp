@@ -0,0 +1,48 @@
+#pragma once
+
+#include "platform.hpp"
+#include <samples/ocv_common.hpp>
+
+/** Decoded detections of all batch images in structure-of-arrays layout, reused between requests **/
+struct DetectionBuffer {
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> w;
+	std::vector<float> h;
+	std::vector<float> conf;
+	std::vector<int> label;
+	std::vector<int> image_id;
+
+	size_t size() const;
+	void clear();
+	void resize(size_t count);
+};
+
+/**
+* Decoder of the SSD DetectionOutput blob: [image_id, label, conf, x_min, y_min, x_max, y_max]
+* per proposal, normalized coordinates, proposals of all batch images followed by a negative image_id.
+* Boxes are made square and enlarged in the same pass as they are scaled to the image size.
+**/
+struct SsdDecoder {
+	static const int objectSize = 7;
+
+	float threshold;
+	float enlarge;
+
+	SsdDecoder(float threshold, float enlarge);
+
+	/** Decodes proposals of images with the given sizes, returns the number of decoded boxes **/
+	size_t decode(const float *detections, int maxProposalCount,
+		const std::vector<cv::Size> &imageSizes, DetectionBuffer &out);
+
+private:
+	std::vector<float> _scaleX;
+	std::vector<float> _scaleY;
+
+	/** Copies proposals above the threshold up to the terminator into the buffer **/
+	size_t select(const float *detections, int maxProposalCount,
+		const std::vector<cv::Size> &imageSizes, DetectionBuffer &out);
+	void append(const float *proposal, const std::vector<cv::Size> &imageSizes, DetectionBuffer &out, size_t &count);
+	/** Scales selected boxes to their images and makes them square and enlarged **/
+	void transform(DetectionBuffer &out, size_t count) const;
+};
@@ -0,0 +1,122 @@
+#include "platform.hpp"
+#include "trace.hpp"
+#include <cstring>
+
+std::unique_ptr<Trace::Slot[]> Trace::_slots;
+size_t Trace::_capacity = 0;
+std::atomic<bool> Trace::_enabled(false);
+std::atomic<uint64_t> Trace::_next(0);
+std::atomic<uint32_t> Trace::_nextThread(0);
+char Trace::_threadNames[Trace::maxThreads][32];
+std::atomic<bool> Trace::_threadNamed[Trace::maxThreads];
+const Trace::clock::time_point Trace::_epoch = Trace::clock::now();
+
+void Trace::enable(size_t capacity) {
+	if (!capacity) {
+		throw std::logic_error("Trace capacity should be at least 1");
+	}
+	// Called before the recording threads start, the ring never changes after that
+	_slots.reset(new Slot[capacity]);
+	for (size_t i = 0; i < capacity; i++) {
+		_slots[i].sequence.store(0, std::memory_order_relaxed);
+	}
+	_capacity = capacity;
+	_next = 0;
+	_enabled.store(true, std::memory_order_release);
+}
+
+bool Trace::enabled() {
+	return _enabled.load(std::memory_order_relaxed);
+}
+
+uint32_t Trace::threadId() {
+	static thread_local uint32_t id = _nextThread.fetch_add(1);
+	return id;
+}
+
+void Trace::nameThread(const std::string &name) {
+	if (!enabled()) return;
+	const uint32_t id = threadId();
+	if (id >= maxThreads) return;
+	std::strncpy(_threadNames[id], name.c_str(), sizeof(_threadNames[id]) - 1);
+	_threadNamed[id].store(true, std::memory_order_release);
+}
+
+void Trace::span(const char *name, clock::time_point begin, size_t frameId, size_t streamId) {
+	record(name, begin, frameId, streamId, false);
+}
+
+void Trace::frameSpan(const char *name, clock::time_point begin, size_t frameId, size_t streamId) {
+	record(name, begin, frameId, streamId, true);
+}
+
+void Trace::record(const char *name, clock::time_point begin, size_t frameId, size_t streamId, bool async) {
+	if (!_enabled.load(std::memory_order_acquire)) return;
+	const clock::time_point end = clock::now();
+
+	const uint64_t index = _next.fetch_add(1, std::memory_order_relaxed);
+	Slot &slot = _slots[index % _capacity];
+	// Sequence lock: a reader keeps the event only if the sequence is even and unchanged around its copy
+	slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.event.name = name;
+	slot.event.beginNs = std::chrono::duration_cast<std::chrono::nanoseconds>(begin - _epoch).count();
+	slot.event.endNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - _epoch).count();
+	slot.event.frameId = frameId;
+	slot.event.streamId = static_cast<uint32_t>(streamId);
+	slot.event.threadId = threadId();
+	slot.event.async = async;
+	slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+void Trace::dump(const std::string &path) {
+	if (!enabled()) return;
+
+	std::vector<Event> events;
+	events.reserve(_capacity);
+	for (size_t i = 0; i < _capacity; i++) {
+		const Slot &slot = _slots[i];
+		const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+		if (!before || (before & 1)) continue;
+		Event event = slot.event;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) != before) continue;
+		events.push_back(event);
+	}
+	std::sort(events.begin(), events.end(), [](const Event &a, const Event &b) { return a.beginNs < b.beginNs; });
+
+	std::ofstream out(path);
+	if (!out) {
+		throw std::logic_error("Cannot open trace file: " + path);
+	}
+	out << std::fixed << std::setprecision(3);
+	out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+	bool first = true;
+	const uint32_t threads = std::min<uint32_t>(_nextThread.load(), maxThreads);
+	for (uint32_t id = 0; id < threads; id++) {
+		if (!_threadNamed[id].load(std::memory_order_acquire)) continue;
+		out << (first ? "" : ",\n") << "{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 0, \"tid\": " << id
+			<< ", \"args\": {\"name\": \"" << _threadNames[id] << "\"}}";
+		first = false;
+	}
+	for (auto &event : events) {
+		out << (first ? "" : ",\n");
+		first = false;
+		std::ostringstream args;
+		args << "\"args\": {\"frame\": " << event.frameId << ", \"stream\": " << event.streamId << "}";
+		if (!event.async) {
+			out << "{\"ph\": \"X\", \"name\": \"" << event.name << "\", \"pid\": 0, \"tid\": " << event.threadId
+				<< ", \"ts\": " << event.beginNs / 1e3 << ", \"dur\": " << (event.endNs - event.beginNs) / 1e3
+				<< ", " << args.str() << "}";
+			continue;
+		}
+		// Frame spans overlap the work of their threads, so they go to their own track per stream
+		std::ostringstream id;
+		id << "\"id\": \"" << event.streamId << ":" << event.frameId << "\"";
+		out << "{\"ph\": \"b\", \"cat\": \"frame\", \"name\": \"" << event.name << "\", \"pid\": 0, \"tid\": " << event.threadId
+			<< ", " << id.str() << ", \"ts\": " << event.beginNs / 1e3 << ", " << args.str() << "},\n";
+		out << "{\"ph\": \"e\", \"cat\": \"frame\", \"name\": \"" << event.name << "\", \"pid\": 0, \"tid\": " << event.threadId
+			<< ", " << id.str() << ", \"ts\": " << event.endNs / 1e3 << "}";
+	}
+	out << "\n]}\n";
+}
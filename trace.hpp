@@ -0,0 +1,59 @@
+#pragma once
+
+#include "platform.hpp"
+#include <atomic>
+#include <cstdint>
+
+/**
+* Optional timeline of pipeline spans in Chrome trace format (chrome://tracing, Perfetto).
+* Spans are written into a ring preallocated by enable(), so recording takes no locks and no
+* allocations and the newest spans overwrite the oldest ones. Until enable() is called every
+* recording call returns right away.
+**/
+class Trace {
+public:
+	typedef std::chrono::high_resolution_clock clock;
+
+	static const size_t maxThreads = 256;
+
+	static void enable(size_t capacity);
+	static bool enabled();
+
+	/** Names the calling thread in the timeline **/
+	static void nameThread(const std::string &name);
+	/** Records a span of the calling thread from begin to now, spans of one thread should nest **/
+	static void span(const char *name, clock::time_point begin, size_t frameId, size_t streamId);
+	/** Records a span of the frame itself from begin to now, e.g. a latency overlapping other work **/
+	static void frameSpan(const char *name, clock::time_point begin, size_t frameId, size_t streamId);
+	/** Writes the spans currently in the ring, may run while other threads keep recording **/
+	static void dump(const std::string &path);
+
+private:
+	struct Event {
+		const char *name;
+		int64_t beginNs;
+		int64_t endNs;
+		uint64_t frameId;
+		uint32_t streamId;
+		uint32_t threadId;
+		bool async;
+	};
+
+	struct Slot {
+		/** Odd while the event is written, 2 * (index + 1) once event index is complete **/
+		std::atomic<uint64_t> sequence;
+		Event event;
+	};
+
+	static std::unique_ptr<Slot[]> _slots;
+	static size_t _capacity;
+	static std::atomic<bool> _enabled;
+	static std::atomic<uint64_t> _next;
+	static std::atomic<uint32_t> _nextThread;
+	static char _threadNames[maxThreads][32];
+	static std::atomic<bool> _threadNamed[maxThreads];
+	static const clock::time_point _epoch;
+
+	static uint32_t threadId();
+	static void record(const char *name, clock::time_point begin, size_t frameId, size_t streamId, bool async);
+};
@@ -0,0 +1,232 @@
+#include "platform.hpp"
+#include "tracker.hpp"
+
+static float median(std::vector<float> &values) {
+	auto middle = values.begin() + values.size() / 2;
+	std::nth_element(values.begin(), middle, values.end());
+	return *middle;
+}
+
+static cv::Point2f center(const cv::Rect &box) {
+	return cv::Point2f(box.x + box.width / 2.f, box.y + box.height / 2.f);
+}
+
+// Overlapping boxes share the corners between them, so each point goes to the nearest box center
+static bool nearestCenter(const Track &track, const std::vector<Track> &tracks, const cv::Point2f &point) {
+	const float distance = static_cast<float>(cv::norm(point - center(track.result.location)));
+	for (auto &other : tracks) {
+		if (&other == &track || !other.result.location.contains(point)) continue;
+		if (cv::norm(point - center(other.result.location)) < distance) return false;
+	}
+	return true;
+}
+
+TrackerHealth::TrackerHealth() : pointsTracked(0), pointsSurvived(0), lostTracks(0), flowSpread(0.f) {
+}
+
+float TrackerHealth::survivalRatio() const {
+	return pointsTracked ? static_cast<float>(pointsSurvived) / pointsTracked : 1.f;
+}
+
+Tracker::Tracker(float matchIouThreshold, int maxMissedDetections, int pointsPerFace)
+	: matchIouThreshold(matchIouThreshold), maxMissedDetections(maxMissedDetections),
+	pointsPerFace(pointsPerFace), refillRatio(0.5f), nextId(0) {
+}
+
+std::vector<Track> Tracker::makeCandidates(const std::vector<FaceDetector::Result> &detections, FrameContext &frame) const {
+	std::vector<Track> candidates;
+	for (auto &detection : detections) {
+		Track candidate;
+		candidate.id = -1;
+		candidate.result = detection;
+		candidate.missedDetections = 0;
+		candidates.push_back(candidate);
+	}
+	for (auto &candidate : candidates) {
+		addPoints(candidate, candidates, frame, true);
+	}
+	return candidates;
+}
+
+TrackerHealth Tracker::track(std::vector<Track> &tracks, FrameContext &prev, FrameContext &next) const {
+	TrackerHealth health;
+
+	// All keypoints go through a single LK call and are split back per track by their offsets
+	std::vector<cv::Point2f> points;
+	for (auto &track : tracks) {
+		points.insert(points.end(), track.points.begin(), track.points.end());
+	}
+	if (points.empty()) {
+		health.lostTracks = tracks.size();
+		return health;
+	}
+
+	std::vector<unsigned char> status;
+	std::vector<float> err;
+	cv::TermCriteria termcrit(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 10, 0.03);
+
+	// Both passes reuse the cached pyramids, and next keeps its pyramid for the following frame pair
+	std::vector<cv::Point2f> points_next, points_rev;
+	cv::calcOpticalFlowPyrLK(prev.pyramid(), next.pyramid(), points, points_next,
+		status, err, FrameContext::flowWindow, FrameContext::flowMaxLevel, termcrit);
+	cv::calcOpticalFlowPyrLK(next.pyramid(), prev.pyramid(), points_next, points_rev,
+		status, err, FrameContext::flowWindow, FrameContext::flowMaxLevel, termcrit);
+
+	size_t offset = 0;
+	size_t movedTracks = 0;
+	std::vector<float> shifts_x, shifts_y;
+	for (auto &track : tracks) {
+		std::vector<cv::Point2f> good_points;
+		shifts_x.clear();
+		shifts_y.clear();
+		for (size_t i = offset; i < offset + track.points.size(); i++) {
+			float diff_x = std::abs(points[i].x - points_rev[i].x);
+			float diff_y = std::abs(points[i].y - points_rev[i].y);
+			if (MAX(diff_x, diff_y) <= 1.0) {
+				good_points.push_back(points_next[i]);
+				shifts_x.push_back(points_next[i].x - points[i].x);
+				shifts_y.push_back(points_next[i].y - points[i].y);
+			}
+		}
+		offset += track.points.size();
+
+		health.pointsTracked += track.points.size();
+		health.pointsSurvived += good_points.size();
+
+		// Median shift keeps the box in place when a few points slide onto the background
+		if (!good_points.empty()) {
+			float shift_x = median(shifts_x);
+			float shift_y = median(shifts_y);
+			track.result.location.x += cvRound(shift_x);
+			track.result.location.y += cvRound(shift_y);
+
+			// Spread of the point shifts around the box shift, relative to the box size
+			float deviation = 0.f;
+			for (size_t i = 0; i < shifts_x.size(); i++) {
+				deviation += std::abs(shifts_x[i] - shift_x) + std::abs(shifts_y[i] - shift_y);
+			}
+			health.flowSpread += deviation / shifts_x.size() / std::max(track.result.location.width, 1);
+			movedTracks++;
+		} else {
+			health.lostTracks++;
+		}
+		track.points = good_points;
+	}
+	if (movedTracks) {
+		health.flowSpread /= movedTracks;
+	}
+	return health;
+}
+
+void Tracker::track(FrameContext &prev, FrameContext &next) {
+	health = track(tracks, prev, next);
+
+	// A lost track has no keypoints left and its box stays where it was lost until a detection finds it
+	const size_t refillBelow = static_cast<size_t>(refillRatio * pointsPerFace);
+	for (auto &track : tracks) {
+		if (!track.points.empty() && track.points.size() < refillBelow) {
+			addPoints(track, tracks, next, false);
+		}
+	}
+}
+
+void Tracker::addPoints(Track &track, const std::vector<Track> &tracks, FrameContext &frame, bool motionOnly) const {
+	const cv::Mat &gray = frame.gray();
+	const cv::Rect region = track.result.location & cv::Rect(cv::Point(), gray.size());
+	const int wanted = pointsPerFace - static_cast<int>(track.points.size());
+	if (region.area() <= 0 || wanted <= 0) return;
+
+	// Keypoints of a face that moved are searched only where it moved, a still face keeps its whole box
+	cv::Mat mask;
+	if (motionOnly && !frame.motion.empty()) {
+		mask = motionMask(frame.motion, gray.size(), region);
+		if (cv::countNonZero(mask) == 0) {
+			mask = cv::Mat();
+		}
+	}
+
+	// Corners come strongest first, twice as many as wanted leave some for cells that are already full
+	std::vector<cv::Point2f> corners;
+	cv::goodFeaturesToTrack(gray(region), corners, 2 * wanted, 0.01, minPointDistance, mask, 3, 3);
+
+	auto cell = [&](const cv::Point2f &point) {
+		const int col = std::max(0, std::min(static_cast<int>((point.x - region.x) * gridSize / region.width), gridSize - 1));
+		const int row = std::max(0, std::min(static_cast<int>((point.y - region.y) * gridSize / region.height), gridSize - 1));
+		return row * gridSize + col;
+	};
+	std::vector<int> counts(gridSize * gridSize, 0);
+	const size_t kept = track.points.size();
+	for (size_t i = 0; i < kept; i++) {
+		counts[cell(track.points[i])]++;
+	}
+
+	// The first pass fills every cell up to its share, the second one takes the corners left over
+	// when the face has too few textured cells to reach pointsPerFace
+	const int share = (pointsPerFace + gridSize * gridSize - 1) / (gridSize * gridSize);
+	const float minDistanceSquared = static_cast<float>(minPointDistance * minPointDistance);
+	std::vector<bool> used(corners.size(), false);
+	for (int pass = 0; pass < 2; pass++) {
+		for (size_t c = 0; c < corners.size() && track.points.size() < static_cast<size_t>(pointsPerFace); c++) {
+			const cv::Point2f point(corners[c].x + region.x, corners[c].y + region.y);
+			int &count = counts[cell(point)];
+			if (used[c] || (pass == 0 && count >= share)) continue;
+			used[c] = true;
+			if (!nearestCenter(track, tracks, point)) continue;
+
+			// New corners keep their distance to each other already, but not to the surviving keypoints
+			bool crowded = false;
+			for (size_t i = 0; i < kept && !crowded; i++) {
+				const cv::Point2f offset = track.points[i] - point;
+				crowded = offset.dot(offset) < minDistanceSquared;
+			}
+			if (crowded) continue;
+			track.points.push_back(point);
+			count++;
+		}
+	}
+}
+
+void Tracker::merge(std::vector<Track> &candidates) {
+	struct Match {
+		float iou;
+		size_t track;
+		size_t candidate;
+	};
+
+	std::vector<Match> matches;
+	for (size_t t = 0; t < tracks.size(); t++) {
+		for (size_t c = 0; c < candidates.size(); c++) {
+			float iou = intersectionOverUnion(tracks[t].result.location, candidates[c].result.location);
+			if (iou >= matchIouThreshold) {
+				matches.push_back({iou, t, c});
+			}
+		}
+	}
+	std::sort(matches.begin(), matches.end(), [](const Match &a, const Match &b) { return a.iou > b.iou; });
+
+	// Greedy assignment by descending IoU
+	std::vector<bool> trackMatched(tracks.size(), false);
+	std::vector<bool> candidateMatched(candidates.size(), false);
+	for (auto &match : matches) {
+		if (trackMatched[match.track] || candidateMatched[match.candidate]) continue;
+		trackMatched[match.track] = true;
+		candidateMatched[match.candidate] = true;
+
+		Track &track = tracks[match.track];
+		track.result = candidates[match.candidate].result;
+		track.points = std::move(candidates[match.candidate].points);
+		track.missedDetections = 0;
+	}
+
+	std::vector<Track> merged;
+	for (size_t t = 0; t < tracks.size(); t++) {
+		if (!trackMatched[t] && ++tracks[t].missedDetections > maxMissedDetections) continue;
+		merged.push_back(std::move(tracks[t]));
+	}
+	for (size_t c = 0; c < candidates.size(); c++) {
+		if (candidateMatched[c]) continue;
+		candidates[c].id = nextId++;
+		merged.push_back(std::move(candidates[c]));
+	}
+	tracks = std::move(merged);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "platform.hpp"
+#include "face_detector.hpp"
+#include "frame_context.hpp"
+#include "motion_gate.hpp"
+
+struct Track {
+	int id;
+	FaceDetector::Result result;
+	std::vector<cv::Point2f> points;
+	int missedDetections;
+};
+
+struct TrackerHealth {
+	size_t pointsTracked;
+	size_t pointsSurvived;
+	size_t lostTracks;
+	float flowSpread;
+
+	TrackerHealth();
+	float survivalRatio() const;
+};
+
+/**
+* Keypoints are searched only inside the box of their face and spread over a grid of its cells, so
+* the cost follows the face area rather than the frame size. Tracks losing keypoints between
+* detections get new ones on the current frame instead of waiting for the next detection.
+**/
+struct Tracker {
+	/** Columns and rows of the cells of a box, each cell holds at most its share of pointsPerFace **/
+	static const int gridSize = 4;
+	/** Smallest distance between two keypoints in pixels **/
+	static const int minPointDistance = 10;
+
+	const float matchIouThreshold;
+	const int maxMissedDetections;
+	const int pointsPerFace;
+	/** Share of pointsPerFace below which a track is topped up after tracking, 0 to never top up **/
+	float refillRatio;
+	int nextId;
+	std::vector<Track> tracks;
+	TrackerHealth health;
+
+	Tracker(float matchIouThreshold = 0.3f, int maxMissedDetections = 2, int pointsPerFace = 50);
+
+	/** Creates unnumbered tracks for detections and seeds their keypoints on the detection frame **/
+	std::vector<Track> makeCandidates(const std::vector<FaceDetector::Result> &detections, FrameContext &frame) const;
+
+	/** Moves every track box along with its own keypoints from prev to next frame **/
+	TrackerHealth track(std::vector<Track> &tracks, FrameContext &prev, FrameContext &next) const;
+	/** Moves the tracks to next frame and tops up those left with too few keypoints **/
+	void track(FrameContext &prev, FrameContext &next);
+
+	/**
+	* Adds corners of the track box on the frame until the track has pointsPerFace keypoints, or
+	* only where the frame moved when motionOnly is set and any part of the box moved. Corners
+	* closer to the center of another of the tracks whose box holds them are left to that track.
+	**/
+	void addPoints(Track &track, const std::vector<Track> &tracks, FrameContext &frame, bool motionOnly) const;
+
+	/** Matches candidates to live tracks by IoU, keeping ids of matched tracks **/
+	void merge(std::vector<Track> &candidates);
+};
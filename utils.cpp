@@ -1,56 +1,220 @@
 #include "platform.hpp"
 #include "utils.h"
 
-CallStat::CallStat() :
-	_number_of_calls(0), _total_duration(0.0), _last_call_duration(0.0), _smoothed_duration(-1.0) {
+static const char *const stageNames[] = {
+	"decode",
+	"detection",
+	"tracker",
+	"analytics",
+	"output",
+	"end_to_end",
+	"visualization"
+};
+
+const char *stageName(Stage stage) {
+	return stageNames[static_cast<int>(stage)];
+}
+
+Stopwatch::Stopwatch() {
+	start();
+}
+
+void Stopwatch::start() {
+	_start = std::chrono::high_resolution_clock::now();
+}
+
+std::chrono::time_point<std::chrono::high_resolution_clock> Stopwatch::startTime() const {
+	return _start;
 }
 
-double CallStat::getSmoothedDuration() {
-	// Additional check is needed for the first frame while duration of the first
-	// visualisation is not calculated yet.
-	if (_smoothed_duration < 0) {
-		auto t = std::chrono::high_resolution_clock::now();
-		return std::chrono::duration_cast<ms>(t - _last_call_start).count();
+std::chrono::nanoseconds Stopwatch::elapsed() const {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - _start);
+}
+
+double Stopwatch::elapsedMs() const {
+	return std::chrono::duration_cast<ms>(elapsed()).count();
+}
+
+
+LatencyHistogram::LatencyHistogram() : _total(0), _sum(0), _max(0) {
+	for (auto &count : _counts) {
+		count.store(0, std::memory_order_relaxed);
 	}
-	return _smoothed_duration;
 }
 
-double CallStat::getTotalDuration() {
-	return _total_duration;
+int LatencyHistogram::bucketOf(uint64_t ns) {
+	uint64_t value = ns >> minShift;
+	// The first subBuckets buckets are linear, each next power of two is split into subBuckets
+	if (value < subBuckets) return static_cast<int>(value);
+	int msb = subBucketBits;
+	while (msb < octaves + subBucketBits - 1 && (value >> (msb + 1))) {
+		msb++;
+	}
+	if (value >> (msb + 1)) return buckets - 1;
+	const int sub = static_cast<int>(value >> (msb - subBucketBits)) & (subBuckets - 1);
+	return (msb - subBucketBits + 1) * subBuckets + sub;
+}
+
+uint64_t LatencyHistogram::lowerBound(int bucket) {
+	if (bucket < subBuckets) return static_cast<uint64_t>(bucket) << minShift;
+	const int msb = bucket / subBuckets + subBucketBits - 1;
+	const uint64_t value = static_cast<uint64_t>(subBuckets + bucket % subBuckets) << (msb - subBucketBits);
+	return value << minShift;
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+	// Single writer, so plain load/store pairs are enough and readers never see torn values
+	std::atomic<uint64_t> &count = _counts[bucketOf(ns)];
+	count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	_sum.store(_sum.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+	if (ns > _max.load(std::memory_order_relaxed)) {
+		_max.store(ns, std::memory_order_relaxed);
+	}
+	_total.store(_total.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+uint64_t LatencyHistogram::count(int bucket) const {
+	return _counts[bucket].load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::total() const {
+	return _total.load(std::memory_order_acquire);
+}
+
+uint64_t LatencyHistogram::sum() const {
+	return _sum.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::max() const {
+	return _max.load(std::memory_order_relaxed);
+}
+
+
+Recorder::Recorder() {
+	restart();
 }
 
-void CallStat::calculateDuration() {
-	auto t = std::chrono::high_resolution_clock::now();
-	_last_call_duration = std::chrono::duration_cast<ms>(t - _last_call_start).count();
-	_number_of_calls++;
-	_total_duration += _last_call_duration;
-	if (_smoothed_duration < 0) {
-		_smoothed_duration = _last_call_duration;
+void Recorder::restart() {
+	for (auto &smoothed : _smoothed) {
+		smoothed = -1.0;
 	}
+}
+
+void Recorder::record(Stage stage, std::chrono::nanoseconds duration) {
+	const int index = static_cast<int>(stage);
+	const uint64_t ns = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
+	_histograms[index].record(ns);
+
+	const double ms = ns / 1e6;
 	double alpha = 0.1;
-	_smoothed_duration = _smoothed_duration * (1.0 - alpha) + _last_call_duration * alpha;
+	_smoothed[index] = _smoothed[index] < 0 ? ms : _smoothed[index] * (1.0 - alpha) + ms * alpha;
+}
+
+double Recorder::smoothedMs(Stage stage) const {
+	return std::max(_smoothed[static_cast<int>(stage)], 0.0);
 }
 
-void CallStat::setStartTime() {
-	_last_call_start = std::chrono::high_resolution_clock::now();
+const LatencyHistogram &Recorder::histogram(Stage stage) const {
+	return _histograms[static_cast<int>(stage)];
 }
 
 
-void Timer::start(const std::string& name) {
-	if (_timers.find(name) == _timers.end()) {
-		_timers[name] = CallStat();
+StageSnapshot::StageSnapshot() : count(0), mean(0.0), p50(0.0), p95(0.0), p99(0.0), max(0.0) {
+}
+
+std::atomic<Recorder *> Instrumentation::_recorders[Instrumentation::maxRecorders];
+std::atomic<bool> Instrumentation::_claimed[Instrumentation::maxRecorders];
+std::atomic<size_t> Instrumentation::_registered(0);
+
+Instrumentation::Claim::Claim() : slot(0), recorder(nullptr) {
+}
+
+Instrumentation::Claim::~Claim() {
+	// The recorder stays published with what it recorded, the next thread claiming it adds to it
+	if (recorder) {
+		_claimed[slot].store(false, std::memory_order_release);
 	}
-	_timers[name].setStartTime();
 }
 
-void Timer::finish(const std::string& name) {
-	auto& timer = (*this)[name];
-	timer.calculateDuration();
+Recorder &Instrumentation::local() {
+	static thread_local Claim claim;
+	if (claim.recorder) return *claim.recorder;
+
+	for (size_t slot = 0; slot < maxRecorders; slot++) {
+		bool claimed = false;
+		// Acquiring the slot makes everything the previous owner recorded visible to the new one
+		if (!_claimed[slot].compare_exchange_strong(claimed, true, std::memory_order_acquire)) continue;
+		Recorder *recorder = _recorders[slot].load(std::memory_order_relaxed);
+		if (!recorder) {
+			recorder = new Recorder();
+			_recorders[slot].store(recorder, std::memory_order_release);
+		}
+		recorder->restart();
+
+		size_t registered = _registered.load();
+		while (registered <= slot && !_registered.compare_exchange_weak(registered, slot + 1)) {
+		}
+		claim.slot = slot;
+		claim.recorder = recorder;
+		return *recorder;
+	}
+	throw std::logic_error("Too many instrumented threads running at once, at most " + std::to_string(maxRecorders) + " are supported");
+}
+
+void Instrumentation::record(Stage stage, std::chrono::nanoseconds duration) {
+	local().record(stage, duration);
 }
 
-CallStat& Timer::operator[](const std::string& name) {
-	if (_timers.find(name) == _timers.end()) {
-		throw std::logic_error("No timer with name " + name + ".");
+StageSnapshot Instrumentation::snapshot(Stage stage) {
+	std::vector<uint64_t> counts(LatencyHistogram::buckets, 0);
+	uint64_t sum = 0;
+	uint64_t max = 0;
+	uint64_t total = 0;
+
+	const size_t registered = _registered.load();
+	for (size_t i = 0; i < registered; i++) {
+		// A slot is claimed before its recorder is published
+		const Recorder *recorder = _recorders[i].load(std::memory_order_acquire);
+		if (!recorder) continue;
+		const LatencyHistogram &histogram = recorder->histogram(stage);
+		// Acquiring the total makes every bucket count recorded before it visible
+		histogram.total();
+		for (int bucket = 0; bucket < LatencyHistogram::buckets; bucket++) {
+			counts[bucket] += histogram.count(bucket);
+		}
+		sum += histogram.sum();
+		max = std::max(max, histogram.max());
 	}
-	return _timers[name];
+	for (auto count : counts) {
+		total += count;
+	}
+
+	StageSnapshot snapshot;
+	if (!total) return snapshot;
+	snapshot.count = total;
+	snapshot.mean = sum / 1e6 / total;
+	snapshot.max = max / 1e6;
+
+	// Percentiles are reported at the middle of their bucket, never above the largest value
+	const double percentiles[] = {50.0, 95.0, 99.0};
+	double *values[] = {&snapshot.p50, &snapshot.p95, &snapshot.p99};
+	for (int p = 0; p < 3; p++) {
+		const uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(percentiles[p] / 100.0 * total)), 1);
+		uint64_t seen = 0;
+		int bucket = 0;
+		while (bucket < LatencyHistogram::buckets - 1 && (seen += counts[bucket]) < rank) {
+			bucket++;
+		}
+		const double middle = (LatencyHistogram::lowerBound(bucket) + LatencyHistogram::lowerBound(bucket + 1)) / 2.0;
+		*values[p] = std::min(middle / 1e6, snapshot.max);
+	}
+	return snapshot;
+}
+
+
+ScopedStage::ScopedStage(Stage stage) : _stage(stage), _recorder(Instrumentation::local()) {
+}
+
+ScopedStage::~ScopedStage() {
+	_recorder.record(_stage, _watch.elapsed());
 }
@@ -1,32 +1,144 @@
 #pragma once
 
 #include "platform.hpp"
+#include <atomic>
+#include <cstdint>
 
-class CallStat {
+/** Instrumented stages, every one has a histogram slot in each recorder **/
+enum class Stage : int {
+	Decode,
+	Detection,
+	Tracker,
+	Analytics,
+	/** Publishing a popped frame to the -out result sink **/
+	Output,
+	/** Capture to Pipeline::pop(), the output of the frame is not included **/
+	EndToEnd,
+	Visualization,
+	Count
+};
+
+const char *stageName(Stage stage);
+
+/** Measures time from construction or the last start() **/
+class Stopwatch {
 public:
 	typedef std::chrono::duration<double, std::ratio<1, 1000>> ms;
 
-	CallStat();
+	Stopwatch();
 
-	double getSmoothedDuration();
-	double getTotalDuration();
-	void calculateDuration();
-	void setStartTime();
+	void start();
+	std::chrono::time_point<std::chrono::high_resolution_clock> startTime() const;
+	std::chrono::nanoseconds elapsed() const;
+	double elapsedMs() const;
 
 private:
-	size_t _number_of_calls;
-	double _total_duration;
-	double _last_call_duration;
-	double _smoothed_duration;
-	std::chrono::time_point<std::chrono::high_resolution_clock> _last_call_start;
+	std::chrono::time_point<std::chrono::high_resolution_clock> _start;
+};
+
+/**
+* Latency histogram with log-scale buckets of fixed layout: every power of two of
+* nanoseconds is split into subBuckets linear buckets, so values are kept within 1/subBuckets
+* of their size from 64 ns up to about 9 minutes. Written by one thread and read by any.
+**/
+class LatencyHistogram {
+public:
+	static const int subBucketBits = 3;
+	static const int subBuckets = 1 << subBucketBits;
+	/** Resolution of the first buckets, 2^minShift ns **/
+	static const int minShift = 6;
+	static const int octaves = 30;
+	static const int buckets = (octaves + 1) * subBuckets;
+
+	LatencyHistogram();
+
+	static int bucketOf(uint64_t ns);
+	static uint64_t lowerBound(int bucket);
+
+	/** Only the owning thread records **/
+	void record(uint64_t ns);
+
+	uint64_t count(int bucket) const;
+	uint64_t total() const;
+	uint64_t sum() const;
+	uint64_t max() const;
+
+private:
+	std::atomic<uint64_t> _counts[buckets];
+	std::atomic<uint64_t> _total;
+	std::atomic<uint64_t> _sum;
+	std::atomic<uint64_t> _max;
+};
+
+/** Histograms of all stages recorded by one thread at a time **/
+class Recorder {
+public:
+	Recorder();
+
+	/** Forgets the moving averages of the previous owner, the histograms keep counting **/
+	void restart();
+	void record(Stage stage, std::chrono::nanoseconds duration);
+	/** Moving average of the stage durations recorded by this thread, for the owning thread only **/
+	double smoothedMs(Stage stage) const;
+	const LatencyHistogram &histogram(Stage stage) const;
+
+private:
+	LatencyHistogram _histograms[static_cast<int>(Stage::Count)];
+	double _smoothed[static_cast<int>(Stage::Count)];
+};
+
+/** Stage latencies merged over all threads, in ms **/
+struct StageSnapshot {
+	uint64_t count;
+	double mean;
+	double p50;
+	double p95;
+	double p99;
+	double max;
+
+	StageSnapshot();
+};
+
+/**
+* Process-wide registry of per-thread recorders. A thread claims a free recorder on its first
+* record, after that recording touches only memory of that thread. A finished thread frees its
+* recorder for the next thread, which keeps adding to the same histograms, so only threads
+* running at once need recorders. Snapshots merge the histograms of all recorders without locking.
+**/
+class Instrumentation {
+public:
+	/** Most instrumented threads running at once **/
+	static const size_t maxRecorders = 256;
+
+	/** Recorder of the calling thread **/
+	static Recorder &local();
+	static void record(Stage stage, std::chrono::nanoseconds duration);
+	static StageSnapshot snapshot(Stage stage);
+
+private:
+	/** Recorder claimed by a thread, freed when the thread exits **/
+	struct Claim {
+		size_t slot;
+		Recorder *recorder;
+
+		Claim();
+		~Claim();
+	};
+
+	static std::atomic<Recorder *> _recorders[maxRecorders];
+	static std::atomic<bool> _claimed[maxRecorders];
+	/** Slots ever used, snapshots read no further **/
+	static std::atomic<size_t> _registered;
 };
 
-class Timer {
+/** Records the time from construction to destruction as one call of the stage **/
+class ScopedStage {
 public:
-	void start(const std::string& name);
-	void finish(const std::string& name);
-	CallStat& operator[](const std::string& name);
+	explicit ScopedStage(Stage stage);
+	~ScopedStage();
 
 private:
-	std::map<std::string, CallStat> _timers;
+	const Stage _stage;
+	Recorder &_recorder;
+	Stopwatch _watch;
 };